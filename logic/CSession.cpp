@@ -1,25 +1,105 @@
 #include "CSession.h"
 #include "LogicSystem.h"
-#include <iostream>
+#include "Logger.h"
+#include "MemoryPool.h"
+#include "MsgHead.h"
+#include "Runtime.h"
 #include <memory>
 #include <nlohmann/json.hpp>
 
 using nlohmann::json;
 
-CSession::CSession(boost::asio::io_context &ioc, Server *server)
-    : _socket(ioc), _server(server), _isHeadParse(false), _isClose(false) {
-  boost::uuids::uuid a_uuid = boost::uuids::random_generator()();
-  _uuid = boost::uuids::to_string(a_uuid);
-  _recvMsgHead = std::make_shared<RecvNode>(HEAD_TOTAL_LEN);
+namespace {
+// 放回对象池前清空容器；突发流量撑大的容量不随空闲会话一直保留
+template <typename T> void clearForPool(std::vector<T> &vec) {
+  if (vec.capacity() > SESSION_POOL_KEEP_CAPACITY) {
+    std::vector<T>().swap(vec);
+  } else {
+    vec.clear();
+  }
+}
+} // namespace
+
+std::atomic<std::uint64_t> CSession::_totalDropCount(0);
+std::atomic<std::uint64_t> CSession::_totalReadPauses(0);
+
+CSession::CSession(boost::asio::io_context &ioc, Server *server,
+                   Runtime &runtime)
+    : _socket(ioc), _server(server), _runtime(runtime), _core(0),
+      _id(INVALID_SESSION_ID),
+      _writing(false), _sendHeadMode(HEAD_FIXED), _sendBytes(0),
+      _lowWatermark(SEND_LOW_WATERMARK), _highWatermark(SEND_HIGH_WATERMARK),
+      _aboveHighWatermark(false), _dropCount(0), _dropBytes(0),
+      _sendHead(0), _writingCount(0), _writingBytes(0), _streamPending(0),
+      _logicPending(0), _readPaused(false), _parked(false), _isClose(false),
+      _logicScheduled(false) {
+  // 注册了流式处理器的消息 id 按分片交给逻辑层
+  LogicSystem *logic = &_runtime.getLogicSystem();
+  _recvBuffer.setStreamFilter(
+      [logic](short msgID) { return logic->isStreamMsg(msgID); });
 }
 
 CSession::~CSession() {
-  std::cout << "~CSession " << _uuid << " destruct" << std::endl;
+  LOG_DEBUG("~CSession %s destruct", getUuid().c_str());
+}
+
+void CSession::attach(tcp::socket socket, std::size_t core) {
+  // 每个线程一个以 mt19937 为源的生成器，只在首次使用时从系统取种子，
+  // 之后生成 uuid 不再进入内核
+  static thread_local boost::uuids::random_generator_mt19937 generator;
+  _socket = std::move(socket);
+  _core = core;
+  _uuid = generator();
 }
 
+void CSession::recycle() {
+  boost::system::error_code ec;
+  _socket.close(ec);
+  _id = INVALID_SESSION_ID;
+  std::shared_ptr<SendNode> node;
+  while (_sendQueue.pop(node)) {
+  }
+  _writing = false;
+  _sendHeadMode = HEAD_FIXED;
+  _sendBytes = 0;
+  _lowWatermark = SEND_LOW_WATERMARK;
+  _highWatermark = SEND_HIGH_WATERMARK;
+  _aboveHighWatermark = false;
+  _dropCount = 0;
+  _dropBytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(_watermarkMutex);
+    _onHighWatermark = nullptr;
+    _onLowWatermark = nullptr;
+  }
+  clearForPool(_sendNodes);
+  _sendHead = 0;
+  clearForPool(_writeBuffers);
+  _writingCount = 0;
+  _writingBytes = 0;
+  _recvBuffer.reset();
+  clearForPool(_logicBatch);
+  _streamPending = 0;
+  _logicPending = 0;
+  _readPaused = false;
+  _parked = false;
+  _isClose = false;
+  _streamHandler.reset();
+  std::shared_ptr<LogicNode> logicNode;
+  while (_logicMailbox.pop(logicNode)) {
+  }
+  _logicScheduled = false;
+}
+
+SessionID CSession::getID() const { return _id; }
+
+void CSession::setID(SessionID id) { _id = id; }
+
 tcp::socket &CSession::getSocket() { return _socket; }
 
-std::string CSession::getUuid() const { return _uuid; }
+std::string CSession::getUuid() const {
+  return boost::uuids::to_string(_uuid);
+}
 
 void CSession::close() {
   _socket.close();
@@ -27,232 +107,345 @@ void CSession::close() {
 }
 
 void CSession::Start() {
-  memset(_data, 0, MAX_LENGTH);
-  _socket.async_read_some(
-      boost::asio::buffer(_data, MAX_LENGTH),
-      std::bind(&CSession::handleRead, this, _1, _2, shared_from_this()));
+  // 空闲等待可读后自己读取，读不到数据时不能阻塞 io 线程
+  boost::system::error_code ec;
+  _socket.non_blocking(true, ec);
+  continueRead(shared_from_this());
 }
 
 void CSession::handleWrite(const boost::system::error_code &error,
                            std::shared_ptr<CSession> selfShared) {
   if (!error) {
-    std::lock_guard<std::mutex> lock(_sendMutex);
-    _sendQueue.pop();
-    if (!_sendQueue.empty()) {
-      auto &msgNode = _sendQueue.front();
-      boost::asio::async_write(
-          _socket, boost::asio::buffer(msgNode->_data, msgNode->_totalLen),
-          std::bind(&CSession::handleWrite, this, _1, selfShared));
+    // 整批写完，一次性释放，全部写完时复位下标
+    for (std::size_t i = 0; i < _writingCount; ++i) {
+      _sendNodes[_sendHead++].reset();
+    }
+    if (_sendHead == _sendNodes.size()) {
+      _sendNodes.clear();
+      _sendHead = 0;
+    }
+    std::size_t queued = _sendBytes.fetch_sub(_writingBytes) - _writingBytes;
+    _writingCount = 0;
+    _writingBytes = 0;
+    // 回落到低水位，通知上层恢复生产
+    if (queued <= _lowWatermark && _aboveHighWatermark.exchange(false)) {
+      WatermarkCallBack onLow;
+      {
+        std::lock_guard<std::mutex> lock(_watermarkMutex);
+        onLow = _onLowWatermark;
+      }
+      if (onLow) {
+        onLow(selfShared, queued);
+      }
     }
+    startWrite(selfShared);
   } else {
-    std::cerr << "write error: " << error.message() << std::endl;
+    LOG_ERROR_LIMITED("write error: %s", error.message().c_str());
     close();
-    _server->clearCSession(_uuid);
+    _server->clearCSession(_id);
+  }
+}
+
+void CSession::startWrite(std::shared_ptr<CSession> selfShared) {
+  std::shared_ptr<SendNode> msgNode;
+  while (true) {
+    while (_sendQueue.pop(msgNode)) {
+      _sendNodes.push_back(std::move(msgNode));
+    }
+    if (_sendHead < _sendNodes.size()) {
+      break;
+    }
+    // 队列已空，清除写标志后再检查一次，防止和生产者的 push 交错丢失通知
+    _writing = false;
+    if (_sendQueue.empty() || _writing.exchange(true)) {
+      return;
+    }
+  }
+  // 把已取出的节点聚合成一次 scatter-gather 写，受字节数和缓冲区个数限制，
+  // 每个节点最多占两个缓冲区（头部 + 引用的消息体）
+  _writeBuffers.clear();
+  _writingCount = 0;
+  std::size_t bytes = 0;
+  for (std::size_t i = _sendHead; i < _sendNodes.size(); ++i) {
+    const std::shared_ptr<SendNode> &node = _sendNodes[i];
+    if (_writeBuffers.size() + 2 > SEND_BATCH_MAX_BUFS) {
+      break;
+    }
+    std::size_t frameLen = node->frameLen();
+    if (_writingCount > 0 && bytes + frameLen > SEND_BATCH_MAX_BYTES) {
+      break;
+    }
+    node->appendBuffers(_writeBuffers);
+    bytes += frameLen;
+    ++_writingCount;
+  }
+  _writingBytes = bytes;
+  boost::asio::async_write(
+      _socket, _writeBuffers,
+      std::bind(&CSession::handleWrite, this, _1, selfShared));
+}
+
+bool CSession::send(boost::string_view msg, short msgID) {
+  HEAD_MODE mode = _sendHeadMode;
+  if (!checkSendLength(msg.size(), msgID, mode) ||
+      !reserveSend(msg.size() + headLen(mode, msgID, msg.size()))) {
+    return false;
+  }
+  pushSendNode(
+      makePoolShared<SendNode>(msg.data(), msg.size(), msgID, mode));
+  return true;
+}
+
+bool CSession::send(std::shared_ptr<MsgNode> body, short msgID) {
+  HEAD_MODE mode = _sendHeadMode;
+  std::size_t len = body->view().size();
+  if (!checkSendLength(len, msgID, mode) ||
+      !reserveSend(len + headLen(mode, msgID, len))) {
+    return false;
+  }
+  pushSendNode(makePoolShared<SendNode>(std::move(body), msgID, mode));
+  return true;
+}
+
+bool CSession::checkSendLength(std::size_t len, short msgID, HEAD_MODE mode) {
+  if (len <= maxBodyLength(mode, msgID)) {
+    return true;
+  }
+  LOG_ERROR_LIMITED("session %s: msg %d body %zu bytes exceeds limit %u",
+                    getUuid().c_str(), msgID, len, maxBodyLength(mode, msgID));
+  return false;
+}
+
+bool CSession::reserveSend(std::size_t len) {
+  std::size_t queued = _sendBytes.fetch_add(len) + len;
+  if (queued > SEND_MAX_BYTES) {
+    // 超过上限丢弃，只计数，由上层根据计数和水位回调处理
+    _sendBytes -= len;
+    ++_dropCount;
+    _dropBytes += len;
+    ++_totalDropCount;
+    return false;
+  }
+  // 越过高水位，通知上层暂停向该会话生产
+  if (queued >= _highWatermark && !_aboveHighWatermark.exchange(true)) {
+    WatermarkCallBack onHigh;
+    {
+      std::lock_guard<std::mutex> lock(_watermarkMutex);
+      onHigh = _onHighWatermark;
+    }
+    if (onHigh) {
+      onHigh(shared_from_this(), queued);
+    }
+  }
+  return true;
+}
+
+void CSession::pushSendNode(std::shared_ptr<SendNode> node) {
+  _sendQueue.push(std::move(node));
+  // 没有写操作在进行时，由抢到标志的生产者把写操作投递到会话所在的 io 线程，
+  // 从其他核心发来时经核心之间的邮箱
+  if (!_writing.exchange(true)) {
+    auto self = shared_from_this();
+    _runtime.postTo(_core, [self]() { self->startWrite(self); });
+  }
+}
+
+void CSession::setWatermarkCallBack(WatermarkCallBack onHigh,
+                                    WatermarkCallBack onLow) {
+  std::lock_guard<std::mutex> lock(_watermarkMutex);
+  _onHighWatermark = std::move(onHigh);
+  _onLowWatermark = std::move(onLow);
+}
+
+void CSession::setSendWatermarks(std::size_t low, std::size_t high) {
+  _lowWatermark = low;
+  _highWatermark = high;
+}
+
+bool CSession::isSendBlocked() const { return _aboveHighWatermark; }
+
+std::size_t CSession::getSendQueueBytes() const { return _sendBytes; }
+
+std::uint64_t CSession::getDropCount() const { return _dropCount; }
+
+std::uint64_t CSession::getDropBytes() const { return _dropBytes; }
+
+std::uint64_t CSession::getTotalDropCount() { return _totalDropCount; }
+
+std::uint64_t CSession::getTotalReadPauses() { return _totalReadPauses; }
+
+void CSession::continueRead(std::shared_ptr<CSession> selfShared) {
+  // 一次读取解析出的所有消息只加一次逻辑队列的锁
+  if (!_logicBatch.empty()) {
+    _runtime.getLogicSystem().postMsgsToQueue(_logicBatch);
   }
+  // 入站积压超过上限时先不读，由逻辑层消费后恢复，对端的发送被 TCP 流控挡住；
+  // 置位后再检查一次，防止和 finishLogicMsg / consumeStream 交错导致无人恢复
+  if (isInboundBlocked()) {
+    _readPaused = true;
+    LogicSystem &logic = _runtime.getLogicSystem();
+    if (logic.isOverloaded()) {
+      logic.parkSession(selfShared);
+    }
+    if (isInboundBlocked() || !_readPaused.exchange(false)) {
+      ++_totalReadPauses;
+      return;
+    }
+  }
+  if (_recvBuffer.empty()) {
+    // 没有半帧时归还接收块，只等待可读，数据到达后再从内存池取块，
+    // 大量空闲连接因此不占接收缓冲区
+    _recvBuffer.release();
+    _socket.async_wait(
+        tcp::socket::wait_read,
+        std::bind(&CSession::handleReadable, this, _1, selfShared));
+    return;
+  }
+  _socket.async_read_some(
+      _recvBuffer.prepare(),
+      std::bind(&CSession::handleRead, this, _1, _2, selfShared));
 }
 
-void CSession::send(std::string msg, short msgID) {
-  bool pending = false;
-  std::lock_guard<std::mutex> lock(_sendMutex);
-  if (_sendQueue.size() > MAX_QUEUE_SIZE) {
-    std::cout << "sendQueue is fulled, size is" << MAX_QUEUE_SIZE << std::endl;
+void CSession::handleReadable(const boost::system::error_code &error,
+                              std::shared_ptr<CSession> selfShared) {
+  if (error) {
+    handleRead(error, 0, selfShared);
+    return;
+  }
+  boost::system::error_code ec;
+  std::size_t len = _socket.read_some(_recvBuffer.prepare(), ec);
+  if (ec == boost::asio::error::would_block ||
+      ec == boost::asio::error::try_again) {
+    // 虚假唤醒，重新进入空闲等待
+    continueRead(selfShared);
     return;
   }
-  if (_sendQueue.size() > 0) {
-    pending = true;
+  handleRead(ec, len, selfShared);
+}
+
+void CSession::consumeStream(std::size_t len) {
+  _streamPending -= len;
+  if (_readPaused) {
+    resumeRead();
   }
-  _sendQueue.push(std::make_shared<SendNode>(msg.c_str(), msg.length(), msgID));
-  if (pending) {
+}
+
+bool CSession::isInboundBlocked() const {
+  return _streamPending > STREAM_WINDOW_BYTES ||
+         _logicPending > LOGIC_SESSION_PENDING_MAX ||
+         _runtime.getLogicSystem().isOverloaded();
+}
+
+void CSession::resumeRead() {
+  // 本会话的积压回落到恢复水位以下才恢复，避免在上限附近反复暂停
+  if (_streamPending > STREAM_WINDOW_BYTES ||
+      _logicPending > LOGIC_SESSION_PENDING_MAX / 2) {
     return;
   }
-  auto &msgnode = _sendQueue.front();
-  boost::asio::async_write(
-      _socket, boost::asio::buffer(msgnode->_data, msgnode->_totalLen),
-      std::bind(&CSession::handleWrite, this, _1, shared_from_this()));
+  LogicSystem &logic = _runtime.getLogicSystem();
+  if (logic.isOverloaded()) {
+    // 登记后再检查一次，防止全局恰好在登记前回落导致无人恢复
+    logic.parkSession(shared_from_this());
+    if (logic.isOverloaded()) {
+      return;
+    }
+  }
+  if (_readPaused.exchange(false)) {
+    auto self = shared_from_this();
+    _runtime.postTo(_core, [self]() {
+      if (!self->_isClose) {
+        self->continueRead(self);
+      }
+    });
+  }
+}
+
+void CSession::finishLogicMsg() {
+  --_logicPending;
+  _runtime.getLogicSystem().finishPending(_core);
+  if (_readPaused) {
+    resumeRead();
+  }
+}
+
+void CSession::abortStream(std::shared_ptr<CSession> selfShared) {
+  std::shared_ptr<RecvNode> abortNode = _recvBuffer.abortStream();
+  if (abortNode) {
+    _logicBatch.push_back(makePoolShared<LogicNode>(selfShared, abortNode));
+  }
+  if (!_logicBatch.empty()) {
+    _runtime.getLogicSystem().postMsgsToQueue(_logicBatch);
+  }
 }
 
 LogicNode::LogicNode(std::shared_ptr<CSession> session,
                      std::shared_ptr<RecvNode> recvnode)
-    : _session(session), _recvNode(recvnode) {}
+    : _session(std::move(session)), _recvNode(std::move(recvnode)) {
+  ++_session->_logicPending;
+  _session->_runtime.getLogicSystem().addPending(_session->_core);
+}
+
+LogicNode::~LogicNode() { _session->finishLogicMsg(); }
 
 void CSession::handleRead(const boost::system::error_code &error,
                           size_t bytes_transferred,
                           std::shared_ptr<CSession> selfShared) {
-  if (!error) {                     // 检查异步读取是否成功（无错误码）
-    int copy_len = 0;               // 已处理（复制）的数据长度
-    while (bytes_transferred > 0) { // 循环处理本次读取到的所有数据
-      if (!_isHeadParse) {          // 未完成头部解析（_b_head_parse
-                                    // 表示是否已解析消息头部）
-        // ----------------------
-        // 处理消息头部（HEAD_LENGTH 为固定长度，如 2 字节表示数据长度）
-        // ----------------------
-        // 情况 1：当前收到的数据不足以填充头部（头部不完整）
-        if (bytes_transferred + _recvMsgHead->_curLen < HEAD_TOTAL_LEN) {
-          // 将剩余数据复制到头部接收缓冲区
-          memcpy(_recvMsgHead->_data + _recvMsgHead->_curLen, _data + copy_len,
-                 bytes_transferred);
-          _recvMsgHead->_curLen += bytes_transferred; // 更新头部已接收长度
-          memset(_data, 0, MAX_LENGTH);               // 清空当前数据缓冲区
-
-          // 继续异步读取数据，补充不完整的头部
-          _socket.async_read_some(
-              boost::asio::buffer(_data, MAX_LENGTH),
-              std::bind(&CSession::handleRead, this, _1, _2, selfShared));
-          return;
-        }
-
-        // 情况 2：当前数据足够解析头部，且包含部分消息体
-        int head_remain =
-            HEAD_TOTAL_LEN - _recvMsgHead->_curLen; // 头部剩余未读取的字节数
-        memcpy(_recvMsgHead->_data + _recvMsgHead->_curLen, _data + copy_len,
-               head_remain);              // 填充完整头部
-        copy_len += head_remain;          // 已处理的数据长度增加
-        bytes_transferred -= head_remain; // 剩余未处理的数据长度减少
-        // 获取消息id
-        short msg_id = 0;
-        memcpy(&msg_id, _recvMsgHead->_data, HEAD_ID_LEN);
-        // 转为本地字节序
-        msg_id = boost::asio::detail::socket_ops::network_to_host_short(msg_id);
-        // 判断id是否合法
-        if (msg_id > MAX_LENGTH) {
-          std::cout << "invalid msg_id " << msg_id << std::endl;
-          _server->clearCSession(_uuid);
-          return;
-        }
-        // 从头部解析出消息体长度
-        short data_len = 0;
-        memcpy(&data_len, _recvMsgHead->_data + HEAD_ID_LEN,
-               HEAD_DATA_LEN); // 读取头部中的数据长度
-        // 转为本地字节序
-        data_len =
-            boost::asio::detail::socket_ops::network_to_host_short(data_len);
-        std::cout << "解析到消息体长度: " << data_len << std::endl;
-
-        // 校验消息体长度是否合法（防止非法数据导致缓冲区溢出）
-        if (data_len > MAX_LENGTH) {
-          std::cout << "非法消息长度: " << data_len
-                    << ", 最大允许长度: " << MAX_LENGTH << std::endl;
-          _server->clearCSession(_uuid); // 清除会话
-          return;
-        }
-
-        // 创建消息体接收节点，初始化总长度为头部指定长度
-        _recvMsgNode = std::make_shared<RecvNode>(data_len);
-
-        // 情况 3：消息体数据未接收完整（当前剩余数据 < 消息体长度）
-        if (bytes_transferred < static_cast<size_t>(data_len)) {
-          memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
-                 bytes_transferred);                  // 复制部分消息体
-          _recvMsgNode->_curLen += bytes_transferred; // 更新已接收的消息体长度
-          memset(_data, 0, MAX_LENGTH);               // 清空当前数据缓冲区
-
-          // 继续异步读取数据，补充不完整的消息体
-          _socket.async_read_some(
-              boost::asio::buffer(_data, MAX_LENGTH),
-              std::bind(&CSession::handleRead, this, _1, _2, selfShared));
-          _isHeadParse = true; // 标记头部已解析，下次进入消息体处理分支
-
-          return;
-        }
-
-        // 情况 4：消息体数据完整（当前剩余数据 >= 消息体长度）
-        memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
-               data_len);                  // 复制完整消息体
-        _recvMsgNode->_curLen += data_len; // 更新已接收的消息体长度
-        copy_len += data_len;              // 已处理的数据长度增加
-        bytes_transferred -= data_len;     // 剩余未处理的数据长度减少
-
-        // 终止符处理（假设消息以 '\0' 结尾，根据协议实际情况调整）
-        _recvMsgNode->_data[_recvMsgNode->_totalLen] = '\0';
-#if 0
-        json js = json::parse(
-            std::string(_recvMsgNode->_data, _recvMsgNode->_totalLen));
-        std::cout << "接收到完整消息: " << js["id"] << " " << js["data"]
-                  << std::endl;
-        // js["data"] = json::array({"server has receieved msg , msg data is",
-        // js["data"]});
-        //  业务逻辑：回显消息（示例）
-        send(js.dump(), js["id"]);
-#endif
-        LogicSystem::getInstance()->postMsgToQueue(
-            std::make_shared<LogicNode>(shared_from_this(), _recvMsgNode));
-
-        // 重置状态，准备处理下一条消息
-        _isHeadParse = false;
-        _recvMsgHead->clear(); // 清空头部接收节点
-
-        // 若还有剩余数据未处理，继续循环（可能包含下一条消息的头部或体）
-        if (bytes_transferred <= 0) {
-          memset(_data, 0, MAX_LENGTH); // 清空当前数据缓冲区
-          _socket.async_read_some(
-              boost::asio::buffer(_data, MAX_LENGTH),
-              std::bind(&CSession::handleRead, this, _1, _2, selfShared));
-          return;
-        }
-      } else {
-        // ----------------------
-        // 处理已解析头部的消息体（续传数据）
-        // ----------------------
-        int remain_msg = _recvMsgNode->_totalLen -
-                         _recvMsgNode->_curLen; // 消息体剩余未接收的字节数
-
-        // 情况 1：当前剩余数据不足以填充消息体
-        if (bytes_transferred < static_cast<size_t>(remain_msg)) {
-          memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
-                 bytes_transferred);                  // 复制部分数据
-          _recvMsgNode->_curLen += bytes_transferred; // 更新已接收长度
-          memset(_data, 0, MAX_LENGTH);               // 清空当前数据缓冲区
-
-          // 继续异步读取数据，补充剩余消息体
-          _socket.async_read_some(
-              boost::asio::buffer(_data, MAX_LENGTH),
-              std::bind(&CSession::handleRead, this, _1, _2, selfShared));
-
-          return;
-        }
-
-        // 情况 2：当前剩余数据足够填充消息体
-        memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
-               remain_msg);                  // 复制完整剩余数据
-        _recvMsgNode->_curLen += remain_msg; // 更新已接收长度
-        bytes_transferred -= remain_msg;     // 剩余未处理的数据长度减少
-        copy_len += remain_msg;              // 已处理的数据长度增加
-
-        // 终止符处理（同上）
-        _recvMsgNode->_data[_recvMsgNode->_totalLen] = '\0';
-#if 0
-        json js = json::parse(
-            std::string(_recvMsgNode->_data, _recvMsgNode->_totalLen));
-        std::cout << "接收到完整消息: " << js["id"] << " " << js["data"]
-                  << std::endl;
-        // js["data"] = json::array({"server has receieved msg , msg data is",
-        // js["data"]});
-        //  业务逻辑：回显消息（示例）
-        send(js.dump(), js["id"]);
-#endif
-        LogicSystem::getInstance()->postMsgToQueue(
-            std::make_shared<LogicNode>(shared_from_this(), _recvMsgNode));
-        // 重置状态，准备处理下一条消息
-        _isHeadParse = false;
-        _recvMsgHead->clear();
-
-        // 若还有剩余数据未处理，继续循环（可能包含下一条消息）
-        if (bytes_transferred <= 0) {
-          memset(_data, 0, MAX_LENGTH); // 清空当前数据缓冲区
-          _socket.async_read_some(
-              boost::asio::buffer(_data, MAX_LENGTH),
-              std::bind(&CSession::handleRead, this, _1, _2, selfShared));
-          return;
-        }
-      }
-    }
-  } else {
+  if (error) {
     // ----------------------
     // 处理读取错误（如连接断开、超时等）
     // ----------------------
-    std::cout << "读取失败，错误码: " << error.value()
-              << ", 错误信息: " << error.message() << std::endl;
+    if (error == boost::asio::error::eof) {
+      LOG_DEBUG("会话 %s 对端关闭", getUuid().c_str());
+    } else {
+      LOG_ERROR_LIMITED("读取失败，错误码: %d, 错误信息: %s", error.value(),
+                        error.message().c_str());
+    }
+    abortStream(selfShared);
     close();                       // 关闭 socket 连接
-    _server->clearCSession(_uuid); // 从服务器中移除当前会话
+    _server->clearCSession(_id); // 从服务器中移除当前会话
+    return;
+  }
+  // 数据已直接读入接收块，原地解析出本次读取中所有完整的消息
+  _recvBuffer.commit(bytes_transferred);
+  LogicSystem &logic = _runtime.getLogicSystem();
+  std::shared_ptr<RecvNode> recvNode;
+  while (true) {
+    RecvBuffer::ParseResult result = _recvBuffer.nextFrame(recvNode);
+    if (result == RecvBuffer::PARSE_NEED_MORE) {
+      break;
+    }
+    if (result == RecvBuffer::PARSE_ERROR) {
+      LOG_ERROR_LIMITED(
+          "非法消息头, id: %d, 长度: %u, 最大允许长度: %u",
+          _recvBuffer.lastMsgID(), _recvBuffer.lastDataLen(),
+          maxBodyLength(_recvBuffer.headMode(), _recvBuffer.lastMsgID()));
+      _logicBatch.clear();
+      abortStream(selfShared);
+      close();
+      _server->clearCSession(_id); // 清除会话
+      return;
+    }
+    if (result == RecvBuffer::PARSE_NEGOTIATE) {
+      // 应答仍按定长头发送，之后本会话的发送才切换到协商的格式
+      char mode = static_cast<char>(_recvBuffer.headMode());
+      send(boost::string_view(&mode, 1), MSG_NEGOTIATE);
+      _sendHeadMode = _recvBuffer.headMode();
+      LOG_DEBUG("会话 %s 消息头格式切换为 %d", getUuid().c_str(), mode);
+      continue;
+    }
+    if (recvNode->getStreamEvent() == STREAM_NONE &&
+        logic.isInlineMsg(recvNode->getMsgID()) && _logicPending == 0) {
+      // 非阻塞的回调直接在本 io 线程上执行，不经过逻辑层的队列；
+      // 本会话还有消息未处理完（包括本次读取中已缓存的）时仍排队，保持顺序
+      logic.dispatchInline(selfShared, recvNode);
+      continue;
+    }
+    if (recvNode->getStreamEvent() == STREAM_CHUNK) {
+      _streamPending += recvNode->view().size();
+    }
+    // 先缓存，本次读取的数据全部解析完后一次性投递
+    _logicBatch.push_back(makePoolShared<LogicNode>(selfShared, recvNode));
   }
+  // 半帧留在接收块中，继续读取补全
+  continueRead(selfShared);
 }
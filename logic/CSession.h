@@ -1,28 +1,74 @@
 #pragma once
+#include "LockedQueue.h"
+#include "MemoryPool.h"
+#include "MpscQueue.h"
 #include "MsgNode.h"
+#include "RecvBuffer.h"
 #include "Server.h"
+#include "SessionRegistry.h"
 #include "const.h"
 #include <boost/asio.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <vector>
 
 using namespace boost::asio::ip;
 using namespace std::placeholders;
 
 class Server;
+class LogicNode;
+class Runtime;
+class StreamHandler;
 
 class CSession : public std::enable_shared_from_this<CSession> {
+  // 逻辑层直接访问会话的流式处理器和消息邮箱
+  friend class LogicSystem;
+  // 消息节点创建和销毁时记账待处理的消息数
+  friend class LogicNode;
+
 public:
-  CSession(boost::asio::io_context &ioc, Server *server);
+  // 发送队列字节数越过水位时的回调，参数为当前排队的字节数
+  using WatermarkCallBack =
+      std::function<void(std::shared_ptr<CSession>, std::size_t queuedBytes)>;
+
+  CSession(boost::asio::io_context &ioc, Server *server, Runtime &runtime);
   ~CSession();
+  // 接管已接入的连接，socket 必须在 runtime 第 core 个 io_context 上，
+  // 会话之后的读写都在该 io 线程上进行
+  void attach(tcp::socket socket, std::size_t core);
+  // 会话不再被引用后复位，放回对象池等待下次 attach
+  void recycle();
   tcp::socket &getSocket();
   std::string getUuid() const;
+  // 会话表中的 id，接入时由 Server 设置
+  SessionID getID() const;
+  void setID(SessionID id);
   void Start();
   void close();
-  void send(std::string msg, short msgID);
+  // 发送队列超过 SEND_MAX_BYTES 时丢弃并返回 false，
+  // 消息体超过当前消息头格式允许的长度时也返回 false
+  bool send(boost::string_view msg, short msgID);
+  // 消息体直接引用 body 的数据发送，不拷贝（如回显收到的消息）
+  bool send(std::shared_ptr<MsgNode> body, short msgID);
+  // 高水位回调在调用 send 的线程上触发，低水位回调在 io 线程上触发
+  void setWatermarkCallBack(WatermarkCallBack onHigh, WatermarkCallBack onLow);
+  void setSendWatermarks(std::size_t low, std::size_t high);
+  // 越过高水位且尚未回落到低水位时为 true，生产者可据此暂停
+  bool isSendBlocked() const;
+  std::size_t getSendQueueBytes() const;
+  std::uint64_t getDropCount() const;
+  std::uint64_t getDropBytes() const;
+  // 所有会话累计丢弃的消息数
+  static std::uint64_t getTotalDropCount();
+  // 所有会话因入站积压暂停读取的累计次数
+  static std::uint64_t getTotalReadPauses();
+  // 流式处理器消费完一段消息体后调用，低于窗口时恢复读取
+  void consumeStream(std::size_t len);
 
 private:
   void handleRead(const boost::system::error_code &error,
@@ -30,26 +76,101 @@ private:
                   std::shared_ptr<CSession> selfShared);
   void handleWrite(const boost::system::error_code &error,
                    std::shared_ptr<CSession> selfShared);
+  void continueRead(std::shared_ptr<CSession> selfShared);
+  // 空闲等待可读后，非阻塞地读入新取的接收块
+  void handleReadable(const boost::system::error_code &error,
+                      std::shared_ptr<CSession> selfShared);
+  // 流式字节数、本会话或全局待处理消息数超过上限时为 true
+  bool isInboundBlocked() const;
+  // 读取暂停后，积压回落到恢复水位以下时在会话的 io 线程上恢复读取；
+  // 只是全局超限时把会话登记到逻辑层，全局回落后统一恢复
+  void resumeRead();
+  // 逻辑层处理完（或丢弃）一条消息，由 LogicNode 析构时调用
+  void finishLogicMsg();
+  // 连接断开时通知逻辑层放弃未接收完的流式消息
+  void abortStream(std::shared_ptr<CSession> selfShared);
+  // 按字节数记账，超过上限返回 false，越过高水位时触发回调
+  bool reserveSend(std::size_t len);
+  // 检查消息体长度是否超过当前消息头格式的上限
+  bool checkSendLength(std::size_t len, short msgID, HEAD_MODE mode);
+  void pushSendNode(std::shared_ptr<SendNode> node);
+  // 只在会话所在的 io 线程上调用
+  void startWrite(std::shared_ptr<CSession> selfShared);
 
   tcp::socket _socket;
-  char _data[MAX_LENGTH];
   Server *_server;
-  std::string _uuid;
-  std::queue<std::shared_ptr<SendNode>> _sendQueue;
-  std::mutex _sendMutex;
-  // 收到的消息结构
-  std::shared_ptr<RecvNode> _recvMsgNode;
-  // 收到的头部结构
-  std::shared_ptr<RecvNode> _recvMsgHead;
-  bool _isHeadParse;
+  Runtime &_runtime;
+  // 会话所属的 io 线程下标
+  std::size_t _core;
+  // 只存 16 字节的二进制形式，需要时再转成字符串
+  boost::uuids::uuid _uuid;
+  SessionID _id;
+  // 逻辑线程投递的待发送节点，多生产者单消费者，实现由 SEND_QUEUE_MPSC 选择
+#if SEND_QUEUE_MPSC
+  MpscQueue<std::shared_ptr<SendNode>, PoolAllocator<std::shared_ptr<SendNode>>>
+      _sendQueue;
+#else
+  LockedQueue<std::shared_ptr<SendNode>,
+              PoolAllocator<std::shared_ptr<SendNode>>>
+      _sendQueue;
+#endif
+  // 是否有写操作在进行（或已投递），保证同一时刻只有一个写
+  std::atomic<bool> _writing;
+  // 发送使用的消息头格式，协商应答发出后才切换
+  std::atomic<HEAD_MODE> _sendHeadMode;
+  // 已入队尚未写完的字节数，以及水位状态
+  std::atomic<std::size_t> _sendBytes;
+  std::atomic<std::size_t> _lowWatermark;
+  std::atomic<std::size_t> _highWatermark;
+  std::atomic<bool> _aboveHighWatermark;
+  std::atomic<std::uint64_t> _dropCount;
+  std::atomic<std::uint64_t> _dropBytes;
+  static std::atomic<std::uint64_t> _totalDropCount;
+  // 回调只在越过水位时读取，用普通锁保护即可
+  std::mutex _watermarkMutex;
+  WatermarkCallBack _onHighWatermark;
+  WatermarkCallBack _onLowWatermark;
+  // 以下只在 io 线程上访问：已从队列取出的节点，以及正在写的一批缓冲区。
+  // 用 vector 加头部下标代替 deque，空闲会话不预先分配内存
+  std::vector<std::shared_ptr<SendNode>> _sendNodes;
+  std::size_t _sendHead;
+  std::vector<boost::asio::const_buffer> _writeBuffers;
+  std::size_t _writingCount;
+  std::size_t _writingBytes;
+  // 接收缓冲区，完整消息以切片形式交给逻辑层
+  RecvBuffer _recvBuffer;
+  // 本次读取中已解析完整、等待投递给逻辑层的消息
+  std::vector<std::shared_ptr<LogicNode>> _logicBatch;
+  // 已交给逻辑层尚未消费的流式消息体字节数，超过窗口时暂停读取
+  std::atomic<std::size_t> _streamPending;
+  // 已交给逻辑层尚未处理完的消息数，超过 LOGIC_SESSION_PENDING_MAX 时暂停读取
+  std::atomic<std::size_t> _logicPending;
+  std::atomic<bool> _readPaused;
+  // 是否已登记在逻辑层等待全局积压回落
+  std::atomic<bool> _parked;
+  static std::atomic<std::uint64_t> _totalReadPauses;
   bool _isClose;
+  // 以下由逻辑层访问。正在接收的流式消息的处理器，
+  // 只由当前处理本会话消息的线程访问
+  std::unique_ptr<StreamHandler> _streamHandler;
+  // LOGIC_WORK_STEALING 模式下本会话待处理的消息（actor 式邮箱），io 线程投递，
+  // 同一时刻只有一个逻辑线程取出处理；_logicScheduled 为 true 表示本会话
+  // 已在某个运行队列中或正在被处理
+  MpscQueue<std::shared_ptr<LogicNode>,
+            PoolAllocator<std::shared_ptr<LogicNode>>>
+      _logicMailbox;
+  std::atomic<bool> _logicScheduled;
 };
 
 class LogicNode {
   friend class LogicSystem;
 
 public:
+  // 构造和析构时增减会话和逻辑层的待处理消息数
   LogicNode(std::shared_ptr<CSession>, std::shared_ptr<RecvNode>);
+  ~LogicNode();
+  LogicNode(const LogicNode &) = delete;
+  LogicNode &operator=(const LogicNode &) = delete;
 
 private:
   std::shared_ptr<CSession> _session;
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 按消息 id 直接下标的回调表。注册时保留可调用对象的具体类型，
+// 生成一个对应的跳板函数，分发时只有一次数组访问和一次函数指针调用，
+// 没有 std::map 的树查找，也没有 std::function/std::bind 的类型擦除开销。
+// 未注册的 id 交给兜底回调。注册应在分发开始前完成，之后只读。
+template <class... Args> class DispatchTable {
+public:
+  explicit DispatchTable(std::size_t maxID)
+      : _entries(maxID, Entry{nullptr, nullptr}),
+        _fallback{&ignore, nullptr} {}
+
+  // 普通函数，编译期绑定
+  template <void (*Fn)(Args...)> void reg(std::size_t id) {
+    _entries.at(id) = Entry{&callFunction<Fn>, nullptr};
+  }
+
+  // 成员函数，编译期绑定，obj 的生命周期需长于回调表
+  template <class T, void (T::*Fn)(Args...)> void reg(std::size_t id, T *obj) {
+    _entries.at(id) = Entry{&callMember<T, Fn>, obj};
+  }
+
+  // lambda 或其他可调用对象，按具体类型保存
+  template <class F> void reg(std::size_t id, F &&f) {
+    _entries.at(id) = makeEntry(std::forward<F>(f));
+  }
+
+  template <class F> void setFallback(F &&f) {
+    _fallback = makeEntry(std::forward<F>(f));
+  }
+
+  bool contains(std::size_t id) const {
+    return id < _entries.size() && _entries[id].invoke != nullptr;
+  }
+
+  void dispatch(std::size_t id, Args... args) const {
+    const Entry &entry = contains(id) ? _entries[id] : _fallback;
+    entry.invoke(entry.ctx, std::forward<Args>(args)...);
+  }
+
+private:
+  using Invoker = void (*)(void *, Args...);
+  struct Entry {
+    Invoker invoke;
+    void *ctx;
+  };
+
+  static void ignore(void *, Args...) {}
+
+  template <void (*Fn)(Args...)> static void callFunction(void *, Args... args) {
+    Fn(std::forward<Args>(args)...);
+  }
+
+  template <class T, void (T::*Fn)(Args...)>
+  static void callMember(void *ctx, Args... args) {
+    (static_cast<T *>(ctx)->*Fn)(std::forward<Args>(args)...);
+  }
+
+  template <class F> static void callObject(void *ctx, Args... args) {
+    (*static_cast<F *>(ctx))(std::forward<Args>(args)...);
+  }
+
+  template <class F> Entry makeEntry(F &&f) {
+    using Fn = typename std::decay<F>::type;
+    auto holder = std::make_shared<Fn>(std::forward<F>(f));
+    _storage.push_back(holder);
+    return Entry{&callObject<Fn>, holder.get()};
+  }
+
+  std::vector<Entry> _entries;
+  Entry _fallback;
+  // 持有 lambda 等可调用对象
+  std::vector<std::shared_ptr<void>> _storage;
+};
@@ -0,0 +1,158 @@
+#include "ExecPool.h"
+#include "Logger.h"
+#include <algorithm>
+
+LatencyBuckets::LatencyBuckets() : _max(0) {
+  for (auto &bucket : _buckets) {
+    bucket = 0;
+  }
+}
+
+void LatencyBuckets::record(std::chrono::steady_clock::duration latency) {
+  std::uint64_t us = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+  // 第 i 个桶为 [2^(i-1), 2^i) 微秒，0 号桶为不足 1 微秒
+  int index = 0;
+  while (index < BUCKETS - 1 && (us >> index) != 0) {
+    ++index;
+  }
+  _buckets[index].fetch_add(1, std::memory_order_relaxed);
+  std::uint64_t prev = _max.load(std::memory_order_relaxed);
+  while (us > prev &&
+         !_max.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+  }
+}
+
+std::uint64_t LatencyBuckets::percentile(double p) const {
+  std::uint64_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+  std::uint64_t target = static_cast<std::uint64_t>(total * p / 100.0);
+  std::uint64_t seen = 0;
+  for (int i = 0; i < BUCKETS; ++i) {
+    seen += _buckets[i].load(std::memory_order_relaxed);
+    if (seen > target) {
+      return std::min(std::uint64_t(1) << i, max());
+    }
+  }
+  return max();
+}
+
+std::uint64_t LatencyBuckets::max() const { return _max; }
+
+std::uint64_t LatencyBuckets::count() const {
+  std::uint64_t total = 0;
+  for (auto &bucket : _buckets) {
+    total += bucket.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+ExecPool::ExecPool(std::string name, std::size_t threads,
+                   std::size_t queueLimit, Handler handler)
+    : _name(std::move(name)), _queueLimit(queueLimit),
+      _handler(std::move(handler)), _isStop(false), _depth(0), _peakDepth(0),
+      _processed(0), _dropped(0) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    _workers.emplace_back(new Worker);
+  }
+  for (auto &worker : _workers) {
+    worker->_thread = std::thread(&ExecPool::run, this, std::ref(*worker));
+  }
+  LOG_INFO("ExecPool %s start, threads %zu, queue limit %zu", _name.c_str(),
+           threads, _queueLimit);
+}
+
+ExecPool::~ExecPool() { stop(); }
+
+void ExecPool::stop() {
+  if (_isStop.exchange(true)) {
+    return;
+  }
+  for (auto &worker : _workers) {
+    // 加锁后再通知，避免工作线程检查完 _isStop 后错过唤醒
+    {
+      std::lock_guard<std::mutex> lock(worker->_mutex);
+    }
+    worker->_cv.notify_one();
+  }
+  for (auto &worker : _workers) {
+    worker->_thread.join();
+  }
+}
+
+bool ExecPool::post(std::shared_ptr<LogicNode> node, std::size_t key,
+                    bool force) {
+  std::size_t depth = _depth.fetch_add(1) + 1;
+  if (!force && depth > _queueLimit) {
+    --_depth;
+    ++_dropped;
+    LOG_ERROR_LIMITED("ExecPool %s queue full (%zu), msg dropped",
+                      _name.c_str(), _queueLimit);
+    return false;
+  }
+  std::size_t peak = _peakDepth.load(std::memory_order_relaxed);
+  while (depth > peak && !_peakDepth.compare_exchange_weak(
+                             peak, depth, std::memory_order_relaxed)) {
+  }
+  Worker &worker = *_workers[key % _workers.size()];
+  std::unique_lock<std::mutex> lock(worker._mutex);
+  worker._queue.push_back(
+      Task{std::move(node), std::chrono::steady_clock::now()});
+  if (worker._queue.size() == 1) {
+    lock.unlock();
+    worker._cv.notify_one();
+  }
+  return true;
+}
+
+const std::string &ExecPool::getName() const { return _name; }
+
+ExecPool::Stats ExecPool::stats() const {
+  Stats stats;
+  stats.name = _name;
+  stats.threads = _workers.size();
+  stats.queueLimit = _queueLimit;
+  stats.depth = _depth;
+  stats.peakDepth = _peakDepth;
+  stats.processed = _processed;
+  stats.dropped = _dropped;
+  stats.waitP50 = _wait.percentile(50);
+  stats.waitP99 = _wait.percentile(99);
+  stats.waitMax = _wait.max();
+  stats.runP50 = _runTime.percentile(50);
+  stats.runP99 = _runTime.percentile(99);
+  stats.runMax = _runTime.max();
+  return stats;
+}
+
+void ExecPool::run(Worker &worker) {
+  std::vector<Task> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(worker._mutex);
+      while (worker._queue.empty() && !_isStop) {
+        worker._cv.wait(lock);
+      }
+      // 关闭状态且队列已取空 退出循环
+      if (worker._queue.empty()) {
+        break;
+      }
+      batch.swap(worker._queue);
+    }
+    for (auto &task : batch) {
+      auto begin = std::chrono::steady_clock::now();
+      _wait.record(begin - task.postTime);
+      _handler(task.node);
+      _runTime.record(std::chrono::steady_clock::now() - begin);
+      task.node.reset();
+      --_depth;
+      ++_processed;
+    }
+    batch.clear();
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LogicNode;
+
+// 按 2 的幂（微秒）分桶的延迟统计，多线程无锁累加，分位数取桶的上界
+class LatencyBuckets {
+public:
+  static const int BUCKETS = 32;
+
+  LatencyBuckets();
+  void record(std::chrono::steady_clock::duration latency);
+  // 单位微秒
+  std::uint64_t percentile(double p) const;
+  std::uint64_t max() const;
+  std::uint64_t count() const;
+
+private:
+  std::atomic<std::uint64_t> _buckets[BUCKETS];
+  std::atomic<std::uint64_t> _max;
+};
+
+// 命名的执行池：独立的线程和队列，用来把耗时的消息 id 和对延迟敏感的消息隔开。
+// 同一个 key（会话）的消息总是进入同一线程的队列，池内保持会话内的顺序；
+// 不同池之间不保证同一会话消息的先后。
+// 排队的消息数达到 queueLimit 时新消息被丢弃并计数（post 返回 false）
+class ExecPool {
+public:
+  using Handler = std::function<void(const std::shared_ptr<LogicNode> &)>;
+
+  struct Stats {
+    std::string name;
+    std::size_t threads;
+    std::size_t queueLimit;
+    // 当前和峰值排队消息数
+    std::size_t depth;
+    std::size_t peakDepth;
+    std::uint64_t processed;
+    std::uint64_t dropped;
+    // 从入队到开始处理、处理本身的耗时（微秒）
+    std::uint64_t waitP50;
+    std::uint64_t waitP99;
+    std::uint64_t waitMax;
+    std::uint64_t runP50;
+    std::uint64_t runP99;
+    std::uint64_t runMax;
+  };
+
+  ExecPool(std::string name, std::size_t threads, std::size_t queueLimit,
+           Handler handler);
+  ~ExecPool();
+  ExecPool(const ExecPool &) = delete;
+  ExecPool &operator=(const ExecPool &) = delete;
+
+  // force 为 true 时不受 queueLimit 限制（如流式消息的分片，丢弃后会话无法恢复读取）
+  bool post(std::shared_ptr<LogicNode> node, std::size_t key, bool force);
+  const std::string &getName() const;
+  Stats stats() const;
+  // 处理完已入队的消息后停止工作线程，可重复调用；析构时也会调用
+  void stop();
+
+private:
+  struct Task {
+    std::shared_ptr<LogicNode> node;
+    std::chrono::steady_clock::time_point postTime;
+  };
+  struct Worker {
+    // 工作线程每次整体交换出队列，回调在锁外执行
+    std::vector<Task> _queue;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::thread _thread;
+  };
+
+  void run(Worker &worker);
+
+  std::string _name;
+  std::size_t _queueLimit;
+  Handler _handler;
+  std::vector<std::unique_ptr<Worker>> _workers;
+  std::atomic<bool> _isStop;
+  std::atomic<std::size_t> _depth;
+  std::atomic<std::size_t> _peakDepth;
+  std::atomic<std::uint64_t> _processed;
+  std::atomic<std::uint64_t> _dropped;
+  LatencyBuckets _wait;
+  LatencyBuckets _runTime;
+};
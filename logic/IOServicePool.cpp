@@ -0,0 +1,66 @@
+#include "IOServicePool.h"
+#include "Logger.h"
+
+constexpr std::size_t IOServicePool::npos;
+
+namespace {
+thread_local std::size_t t_currentIndex = IOServicePool::npos;
+}
+
+IOServicePool::IOServicePool(std::size_t size)
+    : _nextIOService(0), _isStop(false) {
+  if (size == 0) {
+    size = std::thread::hardware_concurrency();
+  }
+  if (size == 0) {
+    size = 1;
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    _ioServices.emplace_back(new IOService(1));
+    // work 防止 io_context 在没有任务时 run 直接返回
+    _works.emplace_back(
+        new Work(boost::asio::make_work_guard(*_ioServices.back())));
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    _threads.emplace_back([this, i]() {
+      t_currentIndex = i;
+      _ioServices[i]->run();
+    });
+  }
+  LOG_INFO("IOServicePool start, size is %zu", size);
+}
+
+IOServicePool::~IOServicePool() { stop(); }
+
+IOServicePool::IOService &IOServicePool::getIOService() {
+  return *_ioServices[nextIndex()];
+}
+
+std::size_t IOServicePool::nextIndex() {
+  return _nextIOService++ % _ioServices.size();
+}
+
+IOServicePool::IOService &IOServicePool::getIOService(std::size_t index) {
+  return *_ioServices[index];
+}
+
+std::size_t IOServicePool::size() const { return _ioServices.size(); }
+
+std::size_t IOServicePool::currentIndex() { return t_currentIndex; }
+
+void IOServicePool::stop() {
+  if (_isStop) {
+    return;
+  }
+  _isStop = true;
+  // 先释放 work，再停止 io_context，最后等待线程退出
+  for (auto &work : _works) {
+    work->reset();
+  }
+  for (auto &ioService : _ioServices) {
+    ioService->stop();
+  }
+  for (auto &t : _threads) {
+    t.join();
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "const.h"
+#include <atomic>
+#include <boost/asio.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// io_context 池：每个 io_context 独占一个线程，
+// 新连接按轮询方式分配到不同的 io_context 上，使读写分散到多个核心
+class IOServicePool {
+public:
+  using IOService = boost::asio::io_context;
+  using Work = boost::asio::executor_work_guard<IOService::executor_type>;
+  using WorkPtr = std::unique_ptr<Work>;
+
+  // size 为 0 时使用 CPU 核心数
+  explicit IOServicePool(std::size_t size = IO_POOL_SIZE);
+  ~IOServicePool();
+  IOServicePool(const IOServicePool &) = delete;
+  IOServicePool &operator=(const IOServicePool &) = delete;
+
+  // 轮询取出下一个 io_context
+  IOService &getIOService();
+  // 轮询取出下一个 io_context 的下标
+  std::size_t nextIndex();
+  // 按下标取 io_context，index 取值 [0, size())
+  IOService &getIOService(std::size_t index);
+  std::size_t size() const;
+  // 当前线程所运行的 io_context 下标，不是池中的线程时返回 npos
+  static std::size_t currentIndex();
+  void stop();
+
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+private:
+  std::vector<std::unique_ptr<IOService>> _ioServices;
+  std::vector<WorkPtr> _works;
+  std::vector<std::thread> _threads;
+  std::atomic<std::size_t> _nextIOService;
+  bool _isStop;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// 加锁的多生产者单消费者队列，接口与 MpscQueue 相同。
+// 生产者加锁追加到入队缓冲；消费者取空本地缓冲后才加锁，
+// 把入队缓冲整体交换过来，一次加锁带走一批节点。
+// push 任意线程可调用，pop/empty 只能由唯一的消费者线程调用。
+template <class T, class Alloc = std::allocator<T>> class LockedQueue {
+public:
+  LockedQueue() = default;
+  LockedQueue(const LockedQueue &) = delete;
+  LockedQueue &operator=(const LockedQueue &) = delete;
+
+  void push(T value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _incoming.push_back(std::move(value));
+  }
+
+  bool pop(T &value) {
+    if (_draining.empty()) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _draining.swap(_incoming);
+    }
+    if (_draining.empty()) {
+      return false;
+    }
+    value = std::move(_draining.front());
+    _draining.pop_front();
+    return true;
+  }
+
+  bool empty() const {
+    if (!_draining.empty()) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _incoming.empty();
+  }
+
+private:
+  mutable std::mutex _mutex;
+  std::deque<T, Alloc> _incoming;
+  // 只由消费者访问
+  std::deque<T, Alloc> _draining;
+};
@@ -0,0 +1,210 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdarg>
+#include <ctime>
+
+namespace {
+// 线程退出阶段环形缓冲区已销毁，此后的日志同步写出
+thread_local LogRing *t_ring = nullptr;
+thread_local bool t_ringDestroyed = false;
+
+struct RingHolder {
+  std::shared_ptr<LogRing> ring;
+  ~RingHolder() {
+    // 交给刷盘线程写完剩余日志后回收
+    ring->closed = true;
+    t_ring = nullptr;
+    t_ringDestroyed = true;
+  }
+};
+
+const char *levelName(int level) {
+  switch (level) {
+  case LOG_LEVEL_DEBUG:
+    return "DEBUG";
+  case LOG_LEVEL_INFO:
+    return "INFO ";
+  case LOG_LEVEL_WARN:
+    return "WARN ";
+  default:
+    return "ERROR";
+  }
+}
+} // namespace
+
+Logger &Logger::instance() {
+  // 其他单例析构时仍会打日志，日志对象有意不析构
+  static Logger *logger = new Logger;
+  return *logger;
+}
+
+Logger::Logger()
+    : _level(LOG_ACTIVE_LEVEL), _file(stdout), _isStop(false),
+      _nextThreadID(1) {
+  _flushThread = std::thread(&Logger::flushLoop, this);
+}
+
+void Logger::setLevel(int level) {
+  _level = level < LOG_ACTIVE_LEVEL ? LOG_ACTIVE_LEVEL : level;
+}
+
+bool Logger::isEnabled(int level) const {
+  return level >= _level.load(std::memory_order_relaxed);
+}
+
+void Logger::setOutput(std::FILE *file) { _file = file; }
+
+LogRing *Logger::localRing() {
+  if (t_ring != nullptr) {
+    return t_ring;
+  }
+  if (t_ringDestroyed) {
+    return nullptr;
+  }
+  static thread_local RingHolder holder;
+  holder.ring = std::make_shared<LogRing>();
+  holder.ring->threadID = _nextThreadID++;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _rings.push_back(holder.ring);
+  }
+  t_ring = holder.ring.get();
+  return t_ring;
+}
+
+void Logger::log(int level, const char *fmt, ...) {
+  LogRing *ring = _isStop ? nullptr : localRing();
+  LogRecord local;
+  LogRecord *record = &local;
+  std::size_t head = 0;
+  if (ring != nullptr) {
+    head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >=
+        LogRing::CAPACITY) {
+      // 缓冲区写满，丢弃而不是阻塞业务线程
+      ring->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    record = &ring->records[head % LogRing::CAPACITY];
+  }
+  record->timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  record->level = static_cast<std::uint16_t>(level);
+  record->threadID = ring != nullptr ? ring->threadID : 0;
+  va_list args;
+  va_start(args, fmt);
+  int len = std::vsnprintf(record->text, LogRecord::TEXT_SIZE, fmt, args);
+  va_end(args);
+  if (len < 0) {
+    len = 0;
+  }
+  record->len = static_cast<std::uint16_t>(
+      len < static_cast<int>(LogRecord::TEXT_SIZE) ? len
+                                                   : LogRecord::TEXT_SIZE - 1);
+  if (ring != nullptr) {
+    ring->head.store(head + 1, std::memory_order_release);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(_drainMutex);
+  write(*record);
+  std::fflush(_file);
+}
+
+void Logger::write(const LogRecord &record) {
+  std::time_t seconds = static_cast<std::time_t>(record.timeNs / 1000000000);
+  int micros = static_cast<int>((record.timeNs % 1000000000) / 1000);
+  std::tm tm;
+  localtime_r(&seconds, &tm);
+  char timeBuf[32];
+  std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", &tm);
+  std::fprintf(_file, "%s.%06d %s [%u] %.*s\n", timeBuf, micros,
+               levelName(record.level), record.threadID,
+               static_cast<int>(record.len), record.text);
+}
+
+std::size_t Logger::drain() {
+  std::vector<std::shared_ptr<LogRing>> rings;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    rings = _rings;
+  }
+  std::lock_guard<std::mutex> lock(_drainMutex);
+  std::size_t written = 0;
+  bool hasClosed = false;
+  for (auto &ring : rings) {
+    // 先读 closed 再读 head，保证回收前已写出所有记录
+    bool closed = ring->closed;
+    std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+    std::size_t head = ring->head.load(std::memory_order_acquire);
+    for (std::size_t i = tail; i != head; ++i) {
+      write(ring->records[i % LogRing::CAPACITY]);
+    }
+    ring->tail.store(head, std::memory_order_release);
+    written += head - tail;
+    std::uint64_t dropped = ring->dropped.exchange(0);
+    if (dropped > 0) {
+      std::fprintf(_file, "%s [%u] %llu log records dropped\n",
+                   levelName(LOG_LEVEL_WARN), ring->threadID,
+                   static_cast<unsigned long long>(dropped));
+      ++written;
+    }
+    hasClosed = hasClosed || closed;
+  }
+  if (written > 0) {
+    std::fflush(_file);
+  }
+  if (hasClosed) {
+    std::lock_guard<std::mutex> ringLock(_mutex);
+    for (auto iter = _rings.begin(); iter != _rings.end();) {
+      if ((*iter)->closed && (*iter)->tail == (*iter)->head) {
+        iter = _rings.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+  return written;
+}
+
+void Logger::flushLoop() {
+  while (!_isStop) {
+    if (drain() > 0) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait_for(lock, std::chrono::milliseconds(10),
+                 [this]() { return _isStop.load(); });
+  }
+  drain();
+}
+
+void Logger::flush() { drain(); }
+
+void Logger::stop() {
+  if (_isStop.exchange(true)) {
+    return;
+  }
+  _cv.notify_one();
+  _flushThread.join();
+  drain();
+}
+
+LogRateLimiter::LogRateLimiter(std::uint32_t limit)
+    : _limit(limit), _window(0), _count(0), _suppressed(0) {}
+
+bool LogRateLimiter::allow(std::uint64_t &suppressed) {
+  std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+  std::int64_t window = _window.load(std::memory_order_relaxed);
+  if (now != window && _window.compare_exchange_strong(window, now)) {
+    _count = 0;
+  }
+  if (_count.fetch_add(1) < _limit) {
+    suppressed = _suppressed.exchange(0);
+    return true;
+  }
+  ++_suppressed;
+  return false;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 日志级别，低于 LOG_ACTIVE_LEVEL 的日志在编译期被去掉
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF 4
+
+#ifndef LOG_ACTIVE_LEVEL
+#define LOG_ACTIVE_LEVEL LOG_LEVEL_INFO
+#endif
+
+// 单条日志记录，定长存放在线程环形缓冲区中，超长内容被截断
+struct LogRecord {
+  static constexpr std::size_t TEXT_SIZE = 240;
+  std::int64_t timeNs;
+  std::uint32_t threadID;
+  std::uint16_t level;
+  std::uint16_t len;
+  char text[TEXT_SIZE];
+};
+
+// 每个线程一个单生产者单消费者环形缓冲区：所属线程写入，刷盘线程读出，
+// 写满时直接丢弃并计数，热路径上不加锁也不做系统调用
+struct LogRing {
+  static constexpr std::size_t CAPACITY = 1024;
+  std::array<LogRecord, CAPACITY> records;
+  std::atomic<std::size_t> head{0};
+  char pad[64];
+  std::atomic<std::size_t> tail{0};
+  std::atomic<std::uint64_t> dropped{0};
+  std::atomic<bool> closed{false};
+  std::uint32_t threadID = 0;
+};
+
+// 异步日志：格式化在调用线程完成，写文件由后台线程批量进行
+class Logger {
+public:
+  static Logger &instance();
+
+  void log(int level, const char *fmt, ...)
+      __attribute__((format(printf, 3, 4)));
+  // 运行期级别，只能比编译期级别更严格
+  void setLevel(int level);
+  bool isEnabled(int level) const;
+  // 默认输出到 stdout
+  void setOutput(std::FILE *file);
+  // 等待当前已写入的日志全部落盘
+  void flush();
+  // 停止后台线程，之后的日志同步写出（用于进程退出阶段）
+  void stop();
+
+private:
+  Logger();
+  LogRing *localRing();
+  void flushLoop();
+  // 把所有线程缓冲区中的日志写出，返回条数
+  std::size_t drain();
+  void write(const LogRecord &record);
+
+  std::atomic<int> _level;
+  std::atomic<std::FILE *> _file;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::vector<std::shared_ptr<LogRing>> _rings;
+  std::mutex _drainMutex;
+  std::atomic<bool> _isStop;
+  std::atomic<std::uint32_t> _nextThreadID;
+  std::thread _flushThread;
+};
+
+// 限速器：每秒最多放行 limit 次，用于错误风暴时避免刷屏
+class LogRateLimiter {
+public:
+  explicit LogRateLimiter(std::uint32_t limit);
+  // 放行时 suppressed 返回上一秒被抑制的次数
+  bool allow(std::uint64_t &suppressed);
+
+private:
+  std::uint32_t _limit;
+  std::atomic<std::int64_t> _window;
+  std::atomic<std::uint32_t> _count;
+  std::atomic<std::uint64_t> _suppressed;
+};
+
+#define LOG_AT(level, ...)                                                     \
+  do {                                                                         \
+    if (Logger::instance().isEnabled(level)) {                                 \
+      Logger::instance().log(level, __VA_ARGS__);                              \
+    }                                                                          \
+  } while (0)
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)                                                         \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...)                                                          \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...)                                                          \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#if LOG_ACTIVE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+// 每个调用点每秒最多输出 LOG_ERROR_RATE_LIMIT 条
+#define LOG_ERROR_LIMITED(fmt, ...)                                            \
+  do {                                                                         \
+    static LogRateLimiter _logLimiter(LOG_ERROR_RATE_LIMIT);                   \
+    std::uint64_t _logSuppressed = 0;                                          \
+    if (_logLimiter.allow(_logSuppressed)) {                                   \
+      if (_logSuppressed > 0) {                                                \
+        LOG_AT(LOG_LEVEL_ERROR, "%llu similar errors suppressed",              \
+               static_cast<unsigned long long>(_logSuppressed));               \
+      }                                                                        \
+      LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__);                             \
+    }                                                                          \
+  } while (0)
+#else
+#define LOG_ERROR(...)                                                         \
+  do {                                                                         \
+  } while (0)
+#define LOG_ERROR_LIMITED(...)                                                 \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#ifndef LOG_ERROR_RATE_LIMIT
+#define LOG_ERROR_RATE_LIMIT 10
+#endif
@@ -1,82 +1,686 @@
 #include "LogicSystem.h"
 #include "CSession.h"
+#include "IOServicePool.h"
+#include "Logger.h"
+#include "MsgDefs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 
-using namespace std::placeholders;
-using nlohmann::json;
 
-LogicSystem::LogicSystem() : _isStop(false) {
+namespace {
+
+// MSG_UPLOAD：边收边计算长度和校验值，结束后回复 UploadAckMsg
+class UploadHandler : public StreamHandler {
+public:
+  UploadHandler() { _ack.checksum = 2166136261u; }
+
+  void onBegin(const std::shared_ptr<CSession> &, short msg_id,
+               std::uint32_t total_len) override {
+    _msgID = msg_id;
+    _totalLen = total_len;
+  }
+
+  void onChunk(const std::shared_ptr<CSession> &, boost::string_view chunk,
+               const std::shared_ptr<RecvNode> &) override {
+    for (char c : chunk) {
+      _ack.checksum ^= static_cast<std::uint8_t>(c);
+      _ack.checksum *= 16777619u;
+    }
+    _ack.size += static_cast<std::uint32_t>(chunk.size());
+  }
+
+  void onEnd(const std::shared_ptr<CSession> &session) override {
+    LOG_DEBUG("session %s upload %u/%u bytes", session->getUuid().c_str(),
+              _ack.size, _totalLen);
+    std::string reply;
+    encodeMsg(_msgID, _ack, reply);
+    session->send(reply, _msgID);
+  }
+
+  void onAbort(const std::shared_ptr<CSession> &session) override {
+    LOG_DEBUG("session %s upload aborted at %u/%u bytes",
+              session->getUuid().c_str(), _ack.size, _totalLen);
+  }
+
+private:
+  short _msgID = 0;
+  std::uint32_t _totalLen = 0;
+  UploadAckMsg _ack;
+};
+
+} // namespace
+
+LogicSystem::LogicSystem(LOGIC_MODE mode, std::size_t coreNum,
+                         std::size_t workerNum)
+    : _mode(mode), _coreNum(coreNum), _isStop(false),
+      _funCallBacks(MAX_MSG_ID), _streamFactories(MAX_MSG_ID), _sleepers(0),
+      _steals(0), _msgPools(MAX_MSG_ID, nullptr), _inlineMsgs(MAX_MSG_ID, 0),
+      _inlineOverruns(0), _peakPendingMsgs(0), _hasParked(false) {
   regCallBack();
-  _workerThread = std::thread(&LogicSystem::dealMsg, this);
+  if (_mode != LOGIC_PER_CORE) {
+    for (std::size_t i = 0; i < _coreNum; ++i) {
+      std::unique_ptr<PendingSlot> slot(new PendingSlot);
+      slot->_count = 0;
+      _pendingSlots.push_back(std::move(slot));
+    }
+  }
+#if LOGIC_INLINE_WATCHDOG
+  for (std::size_t i = 0; i < _coreNum; ++i) {
+    std::unique_ptr<InlineSlot> slot(new InlineSlot);
+    slot->_start = 0;
+    slot->_msgID = 0;
+    slot->_reported = 0;
+    _inlineSlots.push_back(std::move(slot));
+  }
+  _watchdogThread = std::thread(&LogicSystem::watchdogLoop, this);
+#endif
+  if (_mode == LOGIC_PER_CORE) {
+    // 消息在各 io 线程上直接处理，不需要逻辑线程
+    LOG_INFO("LogicSystem per core mode, cores %zu", _coreNum);
+    return;
+  }
+  if (workerNum == 0) {
+    workerNum = std::thread::hardware_concurrency();
+  }
+  if (workerNum == 0) {
+    workerNum = 1;
+  }
+  for (std::size_t i = 0; i < workerNum; ++i) {
+    _shards.emplace_back(new LogicShard);
+  }
+  // 回调表在启动线程前注册完毕，之后只读，多线程访问无需加锁
+  for (std::size_t i = 0; i < _shards.size(); ++i) {
+    if (_mode == LOGIC_WORK_STEALING) {
+      _shards[i]->_workerThread = std::thread(&LogicSystem::stealLoop, this, i);
+    } else {
+      _shards[i]->_workerThread =
+          std::thread(&LogicSystem::dealMsg, this, std::ref(*_shards[i]));
+    }
+  }
+  LOG_INFO("LogicSystem %s mode, workers %zu",
+           _mode == LOGIC_WORK_STEALING ? "work stealing" : "threaded",
+           _shards.size());
 }
 
 void LogicSystem::regCallBack() {
-  _funCallBacks[MSG_HELLO_WORLD] =
-      std::bind(&LogicSystem::helloWorldCallBack, this, _1, _2, _3);
+  _funCallBacks.reg<LogicSystem, &LogicSystem::helloWorldCallBack>(
+      MSG_HELLO_WORLD, this);
+  // 回显只解码后把接收块交给发送队列，比投递到逻辑线程的开销还小；
+  // 只在开启 LOGIC_INLINE_HANDLERS 时生效
+  markNonBlocking(MSG_HELLO_WORLD);
+  _funCallBacks.setFallback(
+      [this](const std::shared_ptr<CSession> &session, short msg_id,
+             boost::string_view msg_data,
+             const std::shared_ptr<RecvNode> &msg_node) {
+        unknownMsgCallBack(session, msg_id, msg_data, msg_node);
+      });
+  regStreamHandler(MSG_UPLOAD, []() {
+    return std::unique_ptr<StreamHandler>(new UploadHandler);
+  });
+  // 上传逐字节计算校验值，大消息会长时间占住线程，放到单独的池中
+  addPool("bulk", LOGIC_BULK_POOL_THREADS, LOGIC_BULK_POOL_QUEUE_LIMIT);
+  bindPool(MSG_UPLOAD, "bulk");
+}
+
+void LogicSystem::markNonBlocking(short msgID) {
+#if LOGIC_INLINE_HANDLERS
+  if (isStreamMsg(msgID) || _msgPools.at(msgID) != nullptr) {
+    LOG_ERROR("msg id %d is stream or pool bound, cannot run inline", msgID);
+    return;
+  }
+  _inlineMsgs.at(msgID) = 1;
+#endif
+}
+
+bool LogicSystem::isInlineMsg(short msgID) const {
+  return msgID >= 0 && msgID < static_cast<short>(_inlineMsgs.size()) &&
+         _inlineMsgs[msgID] != 0;
+}
+
+void LogicSystem::dispatchInline(const std::shared_ptr<CSession> &session,
+                                 const std::shared_ptr<RecvNode> &recvNode) {
+  short msgID = recvNode->getMsgID();
+#if LOGIC_INLINE_WATCHDOG
+  std::size_t core = IOServicePool::currentIndex();
+  InlineSlot *slot = core < _inlineSlots.size() ? _inlineSlots[core].get()
+                                                : nullptr;
+  auto begin = std::chrono::steady_clock::now();
+  if (slot) {
+    slot->_msgID.store(msgID, std::memory_order_relaxed);
+    slot->_start.store(begin.time_since_epoch().count(),
+                       std::memory_order_release);
+  }
+  _funCallBacks.dispatch(msgID, session, msgID, recvNode->view(), recvNode);
+  if (slot) {
+    slot->_start.store(0, std::memory_order_release);
+  }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin)
+                .count();
+  if (us > LOGIC_INLINE_WARN_US) {
+    ++_inlineOverruns;
+    LOG_ERROR_LIMITED("inline handler for msg id %d took %lld us, "
+                      "it should not be marked non-blocking",
+                      msgID, static_cast<long long>(us));
+  }
+#else
+  _funCallBacks.dispatch(msgID, session, msgID, recvNode->view(), recvNode);
+#endif
+}
+
+std::uint64_t LogicSystem::getInlineOverruns() const {
+  return _inlineOverruns;
+}
+
+void LogicSystem::watchdogLoop() {
+  using Clock = std::chrono::steady_clock;
+  const std::int64_t warn =
+      std::chrono::duration_cast<Clock::duration>(
+          std::chrono::microseconds(LOGIC_INLINE_WARN_US))
+          .count();
+  std::unique_lock<std::mutex> lock(_watchdogMutex);
+  while (!_isStop) {
+    _watchdogCv.wait_for(lock,
+                         std::chrono::milliseconds(LOGIC_INLINE_WATCHDOG_MS));
+    std::int64_t now = Clock::now().time_since_epoch().count();
+    for (std::size_t core = 0; core < _inlineSlots.size(); ++core) {
+      InlineSlot &slot = *_inlineSlots[core];
+      std::int64_t start = slot._start.load(std::memory_order_acquire);
+      // 回调阻塞不返回时 io 线程自己无法报告，由看门狗报告仍在执行的回调
+      if (start != 0 && start != slot._reported && now - start > warn) {
+        slot._reported = start;
+        LOG_WARN("inline handler for msg id %d has been running %lld us on "
+                 "io thread %zu",
+                 slot._msgID.load(std::memory_order_relaxed),
+                 static_cast<long long>(
+                     std::chrono::duration_cast<std::chrono::microseconds>(
+                         Clock::duration(now - start))
+                         .count()),
+                 core);
+      }
+    }
+  }
+}
+
+void LogicSystem::addPool(const std::string &name, std::size_t threads,
+                          std::size_t queueLimit) {
+  _pools.emplace_back(new ExecPool(
+      name, threads, queueLimit,
+      [this](const std::shared_ptr<LogicNode> &msgNode) {
+        dispatchMsg(msgNode);
+      }));
 }
 
-void LogicSystem::helloWorldCallBack(std::shared_ptr<CSession> session,
-                                     const short &msg_id,
-                                     const std::string &msg_data) {
-  json js = json::parse(msg_data);
-  std::cout << "server recv id is" << js["id"] << " data is" << js["data"]
-            << std::endl;
-  session->send(js.dump(), msg_id);
+void LogicSystem::bindPool(short msgID, const std::string &name) {
+  for (auto &pool : _pools) {
+    if (pool->getName() == name) {
+      _msgPools.at(msgID) = pool.get();
+      return;
+    }
+  }
+  LOG_ERROR("bind msg id %d to unknown pool %s", msgID, name.c_str());
+}
+
+std::vector<ExecPool::Stats> LogicSystem::poolStats() const {
+  if (_isStop) {
+    return _stoppedPoolStats;
+  }
+  std::vector<ExecPool::Stats> stats;
+  for (auto &pool : _pools) {
+    stats.push_back(pool->stats());
+  }
+  return stats;
 }
 
-void LogicSystem::dealMsg() {
+void LogicSystem::regStreamHandler(short msgID, StreamHandlerFactory factory) {
+  _streamFactories.at(msgID) = std::move(factory);
+}
+
+bool LogicSystem::isStreamMsg(short msgID) const {
+  return msgID >= 0 && msgID < static_cast<short>(_streamFactories.size()) &&
+         _streamFactories[msgID] != nullptr;
+}
+
+void LogicSystem::helloWorldCallBack(const std::shared_ptr<CSession> &session,
+                                     short msg_id, boost::string_view msg_data,
+                                     const std::shared_ptr<RecvNode> &msg_node) {
+  // 按 const.h 中为该 id 配置的格式（二进制或 JSON）解码
+  HelloWorldMsg msg;
+  if (!decodeMsg(msg_id, msg_data, msg)) {
+    LOG_ERROR_LIMITED("session %s: bad hello world body, len %zu",
+                      session->getUuid().c_str(), msg_data.size());
+    return;
+  }
+  LOG_DEBUG("server recv id is %d data is %s", msg.id, msg.data.c_str());
+  // 回显原始消息体，发送节点引用接收块，不再重新编码和拷贝
+  session->send(msg_node, msg_id);
+}
+
+void LogicSystem::unknownMsgCallBack(const std::shared_ptr<CSession> &session,
+                                     short msg_id, boost::string_view msg_data,
+                                     const std::shared_ptr<RecvNode> &) {
+  LOG_ERROR_LIMITED("session %s: no callback for msg id %d, len %zu",
+                    session->getUuid().c_str(), msg_id, msg_data.size());
+}
+
+void LogicSystem::dispatchMsg(const std::shared_ptr<LogicNode> &msgNode) {
+  LOG_DEBUG("recv msg id is %d", msgNode->_recvNode->getMsgID());
+  if (msgNode->_recvNode->getStreamEvent() != STREAM_NONE) {
+    dispatchStream(msgNode);
+    return;
+  }
+  /*调用回调函数，未注册的 id 走兜底回调*/
+  const std::shared_ptr<RecvNode> &recvNode = msgNode->_recvNode;
+  _funCallBacks.dispatch(recvNode->getMsgID(), msgNode->_session,
+                         recvNode->getMsgID(), recvNode->view(), recvNode);
+}
+
+void LogicSystem::dispatchStream(const std::shared_ptr<LogicNode> &msgNode) {
+  const std::shared_ptr<CSession> &session = msgNode->_session;
+  const std::shared_ptr<RecvNode> &recvNode = msgNode->_recvNode;
+  // 处理器挂在会话上，同一会话的事件同一时刻只有一个线程在处理
+  std::unique_ptr<StreamHandler> &handler = session->_streamHandler;
+  switch (recvNode->getStreamEvent()) {
+  case STREAM_BEGIN:
+    handler = _streamFactories[recvNode->getMsgID()]();
+    handler->onBegin(session, recvNode->getMsgID(), recvNode->getStreamLen());
+    break;
+  case STREAM_CHUNK:
+    // 处理器为空说明 BEGIN 之前就被丢弃了
+    if (handler) {
+      handler->onChunk(session, recvNode->view(), recvNode);
+    }
+    // 归还接收窗口，让会话继续读取
+    session->consumeStream(recvNode->view().size());
+    break;
+  case STREAM_END:
+    if (handler) {
+      handler->onEnd(session);
+      handler.reset();
+    }
+    break;
+  case STREAM_ABORT:
+    if (handler) {
+      handler->onAbort(session);
+      handler.reset();
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void LogicSystem::dealMsg(LogicShard &shard) {
+  std::vector<std::shared_ptr<LogicNode>> batch;
   while (1) {
-    std::unique_lock<std::mutex> unique_lk(_mutex);
-    // 判断队列为空 则用条件变量等待
-    while (_msgQueue.empty() && !_isStop) {
-      _cv.wait(unique_lk);
-    }
-    // 如果为关闭状态 取出逻辑队列所有数据 并退出循环
-    if (_isStop) {
-      while (!_msgQueue.empty()) {
-        auto msgNode = _msgQueue.front();
-        std::cout << "recv msg id is" << msgNode->_recvNode->getMsgID()
-                  << std::endl;
-        auto callBackIter = _funCallBacks.find(msgNode->_recvNode->getMsgID());
-        if (callBackIter != _funCallBacks.end()) {
-          /*调用回调函数*/
-          callBackIter->second(msgNode->_session,
-                               msgNode->_recvNode->getMsgID(),
-                               std::string(msgNode->_recvNode->_data,
-                                           msgNode->_recvNode->_curLen));
-        }
-        _msgQueue.pop();
+    {
+      std::unique_lock<std::mutex> unique_lk(shard._mutex);
+      // 判断队列为空 则用条件变量等待
+      while (shard._msgQueue.empty() && !_isStop) {
+        shard._cv.wait(unique_lk);
       }
-      break;
+      // 关闭状态且队列已取空 退出循环
+      if (shard._msgQueue.empty()) {
+        break;
+      }
+      // 在锁内整批取出，回调在锁外执行，不阻塞 io 线程投递
+      batch.swap(shard._msgQueue);
     }
-    /*队列不为空 且未停止*/
-    auto msgNode = _msgQueue.front();
-    std::cout << "recv msg id is " << msgNode->_recvNode->getMsgID()
-              << std::endl;
-    auto callBackIter = _funCallBacks.find(msgNode->_recvNode->getMsgID());
-    if (callBackIter != _funCallBacks.end()) {
-      std::cout<<"callback"<<std::endl;
-      /*调用回调函数*/
-      callBackIter->second(
-          msgNode->_session, msgNode->_recvNode->getMsgID(),
-          std::string(msgNode->_recvNode->_data, msgNode->_recvNode->_curLen));
+    for (auto &msgNode : batch) {
+      dispatchMsg(msgNode);
+    }
+    batch.clear();
+  }
+}
+
+std::size_t LogicSystem::sessionKey(const std::shared_ptr<CSession> &session) {
+  // 会话地址按 16 字节对齐，先打散低位再取模，避免都落到少数分片上
+  std::uint64_t key = reinterpret_cast<std::uintptr_t>(session.get());
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return static_cast<std::size_t>(key);
+}
+
+std::size_t
+LogicSystem::selectShard(const std::shared_ptr<CSession> &session) const {
+  return sessionKey(session) % _shards.size();
+}
+
+void LogicSystem::postToPools(std::vector<std::shared_ptr<LogicNode>> &msgs) {
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < msgs.size(); ++i) {
+    std::shared_ptr<LogicNode> &msgNode = msgs[i];
+    const std::shared_ptr<RecvNode> &recvNode = msgNode->_recvNode;
+    short msgID = recvNode->getMsgID();
+    ExecPool *pool = (msgID >= 0 && msgID < MAX_MSG_ID) ? _msgPools[msgID]
+                                                        : nullptr;
+    if (pool == nullptr) {
+      if (kept != i) {
+        msgs[kept] = std::move(msgNode);
+      }
+      ++kept;
+      continue;
     }
-    _msgQueue.pop();
+    // 流式消息的事件不能丢：丢掉分片后接收窗口不会归还，会话停止读取
+    bool force = recvNode->getStreamEvent() != STREAM_NONE;
+    std::size_t key = sessionKey(msgNode->_session);
+    pool->post(std::move(msgNode), key, force);
+  }
+  msgs.resize(kept);
+}
+
+void LogicSystem::dispatchLocal(const std::shared_ptr<LogicNode> &msgNode) {
+  // 会话只在所属的 io 线程上读取和投递，会话上的处理器状态不会被其他线程访问
+  if (IOServicePool::currentIndex() >= _coreNum) {
+    LOG_ERROR_LIMITED("per core dispatch outside io thread, msg id %d dropped",
+                      msgNode->_recvNode->getMsgID());
+    return;
   }
+  dispatchMsg(msgNode);
 }
 
 void LogicSystem::postMsgToQueue(std::shared_ptr<LogicNode> msg) {
-  std::unique_lock<std::mutex> unique_lk(_mutex);
-  _msgQueue.push(msg);
-  if (_msgQueue.size() == 1) {
+  short msgID = msg->_recvNode->getMsgID();
+  if (msgID >= 0 && msgID < MAX_MSG_ID && _msgPools[msgID] != nullptr) {
+    std::vector<std::shared_ptr<LogicNode>> msgs{std::move(msg)};
+    postToPools(msgs);
+    return;
+  }
+  if (_mode == LOGIC_PER_CORE) {
+    dispatchLocal(msg);
+    return;
+  }
+  if (_mode == LOGIC_WORK_STEALING) {
+    std::vector<std::shared_ptr<LogicNode>> msgs{std::move(msg)};
+    postToMailbox(msgs);
+    return;
+  }
+  LogicShard &shard = *_shards[selectShard(msg->_session)];
+  std::unique_lock<std::mutex> unique_lk(shard._mutex);
+  shard._msgQueue.push_back(std::move(msg));
+  if (shard._msgQueue.size() == 1) {
     unique_lk.unlock();
-    _cv.notify_one();
+    shard._cv.notify_one();
   }
 }
 
-LogicSystem::~LogicSystem(){
-  _isStop=true;
-  /*唤醒消费者线程*/
-  _cv.notify_one();
-  _workerThread.join();
-}
\ No newline at end of file
+void LogicSystem::postMsgsToQueue(
+    std::vector<std::shared_ptr<LogicNode>> &msgs) {
+  if (!_pools.empty()) {
+    postToPools(msgs);
+  }
+  if (msgs.empty()) {
+    return;
+  }
+  if (_mode == LOGIC_PER_CORE) {
+    for (auto &msgNode : msgs) {
+      dispatchLocal(msgNode);
+    }
+    msgs.clear();
+    return;
+  }
+  if (_mode == LOGIC_WORK_STEALING) {
+    postToMailbox(msgs);
+    return;
+  }
+  LogicShard &shard = *_shards[selectShard(msgs.front()->_session)];
+  std::unique_lock<std::mutex> unique_lk(shard._mutex);
+  bool wasEmpty = shard._msgQueue.empty();
+  shard._msgQueue.insert(shard._msgQueue.end(),
+                         std::make_move_iterator(msgs.begin()),
+                         std::make_move_iterator(msgs.end()));
+  unique_lk.unlock();
+  msgs.clear();
+  if (wasEmpty) {
+    shard._cv.notify_one();
+  }
+}
+
+LOGIC_MODE LogicSystem::getMode() const { return _mode; }
+
+void LogicSystem::addPending(std::size_t core) {
+  if (core < _pendingSlots.size()) {
+    ++_pendingSlots[core]->_count;
+  }
+}
+
+void LogicSystem::finishPending(std::size_t core) {
+  if (core >= _pendingSlots.size()) {
+    return;
+  }
+  --_pendingSlots[core]->_count;
+  // 先减计数再看登记标志，与 parkSession 先置标志再看计数配对，不会漏掉唤醒；
+  // 没有会话在等待时不汇总各核心的计数
+  if (_hasParked && getPendingMsgs() <= LOGIC_TOTAL_PENDING_LOW) {
+    wakeParked();
+  }
+}
+
+bool LogicSystem::isOverloaded() {
+  if (_pendingSlots.empty()) {
+    return false;
+  }
+  std::size_t pending = getPendingMsgs();
+  std::size_t peak = _peakPendingMsgs.load(std::memory_order_relaxed);
+  while (pending > peak && !_peakPendingMsgs.compare_exchange_weak(
+                               peak, pending, std::memory_order_relaxed)) {
+  }
+  return pending > LOGIC_TOTAL_PENDING_MAX;
+}
+
+void LogicSystem::parkSession(const std::shared_ptr<CSession> &session) {
+  if (session->_parked.exchange(true)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(_parkedMutex);
+  _parked.push_back(session);
+  _hasParked = true;
+}
+
+void LogicSystem::wakeParked() {
+  std::vector<std::weak_ptr<CSession>> parked;
+  {
+    std::lock_guard<std::mutex> lock(_parkedMutex);
+    if (_parked.empty()) {
+      return;
+    }
+    parked.swap(_parked);
+    _hasParked = false;
+  }
+  for (auto &weak : parked) {
+    std::shared_ptr<CSession> session = weak.lock();
+    if (!session) {
+      continue;
+    }
+    session->_parked = false;
+    if (session->_readPaused) {
+      session->resumeRead();
+    }
+  }
+}
+
+std::size_t LogicSystem::getPendingMsgs() const {
+  std::size_t total = 0;
+  for (auto &slot : _pendingSlots) {
+    total += slot->_count;
+  }
+  return total;
+}
+
+std::size_t LogicSystem::getPeakPendingMsgs() const {
+  return _peakPendingMsgs;
+}
+
+std::uint64_t LogicSystem::getStealCount() const { return _steals; }
+
+void LogicSystem::postToMailbox(std::vector<std::shared_ptr<LogicNode>> &msgs) {
+  std::shared_ptr<CSession> session = msgs.front()->_session;
+  for (auto &msgNode : msgs) {
+    session->_logicMailbox.push(std::move(msgNode));
+  }
+  msgs.clear();
+  // 会话已在运行队列中或正在处理时，处理它的线程会看到新消息
+  if (!session->_logicScheduled.exchange(true, std::memory_order_acq_rel)) {
+    std::size_t index = selectShard(session);
+    pushRunnable(index, std::move(session), true);
+  }
+}
+
+void LogicSystem::pushRunnable(std::size_t index,
+                               std::shared_ptr<CSession> session,
+                               bool external) {
+  LogicShard &shard = *_shards[index];
+  std::size_t queued = 0;
+  {
+    std::lock_guard<std::mutex> lock(shard._mutex);
+    shard._runQueue.push_back(std::move(session));
+    queued = shard._runQueue.size();
+  }
+  // 外部投递时目标线程可能在睡眠；线程自己重新排队时，
+  // 队列中不止这一个会话才值得叫醒别的线程来窃取
+  if ((external || queued > 1) && _sleepers > 0) {
+    std::lock_guard<std::mutex> lock(_idleMutex);
+    _idleCv.notify_one();
+  }
+}
+
+bool LogicSystem::popRunnable(std::size_t index,
+                              std::shared_ptr<CSession> &session) {
+  LogicShard &shard = *_shards[index];
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  if (shard._runQueue.empty()) {
+    return false;
+  }
+  session = std::move(shard._runQueue.front());
+  shard._runQueue.pop_front();
+  return true;
+}
+
+bool LogicSystem::stealRunnable(std::size_t index,
+                                std::shared_ptr<CSession> &session) {
+  std::vector<std::shared_ptr<CSession>> stolen;
+  for (std::size_t i = 1; i < _shards.size(); ++i) {
+    LogicShard &victim = *_shards[(index + i) % _shards.size()];
+    {
+      std::lock_guard<std::mutex> lock(victim._mutex);
+      // 从队尾取走一半（至少一个），队头留给原线程
+      std::size_t count = (victim._runQueue.size() + 1) / 2;
+      for (std::size_t k = 0; k < count; ++k) {
+        stolen.push_back(std::move(victim._runQueue.back()));
+        victim._runQueue.pop_back();
+      }
+    }
+    if (!stolen.empty()) {
+      break;
+    }
+  }
+  if (stolen.empty()) {
+    return false;
+  }
+  ++_steals;
+  // 取出时是倒序，最早排队的留给自己先运行，其余按原顺序放入本线程的队列
+  session = std::move(stolen.back());
+  stolen.pop_back();
+  if (!stolen.empty()) {
+    LogicShard &self = *_shards[index];
+    std::lock_guard<std::mutex> lock(self._mutex);
+    for (auto iter = stolen.rbegin(); iter != stolen.rend(); ++iter) {
+      self._runQueue.push_back(std::move(*iter));
+    }
+  }
+  return true;
+}
+
+bool LogicSystem::hasRunnable() {
+  for (auto &shard : _shards) {
+    std::lock_guard<std::mutex> lock(shard->_mutex);
+    if (!shard->_runQueue.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LogicSystem::runSession(std::size_t index,
+                             std::shared_ptr<CSession> &session) {
+  std::shared_ptr<LogicNode> msgNode;
+  for (int i = 0; i < LOGIC_SESSION_BUDGET && session->_logicMailbox.pop(msgNode);
+       ++i) {
+    dispatchMsg(msgNode);
+  }
+  msgNode.reset();
+  if (!session->_logicMailbox.empty()) {
+    // 本次配额用完，排到队尾，让其他会话先运行
+    pushRunnable(index, std::move(session), false);
+    return;
+  }
+  // 先清标志再检查一次邮箱，防止和 io 线程的投递交错导致会话无人调度
+  session->_logicScheduled.exchange(false, std::memory_order_acq_rel);
+  if (!session->_logicMailbox.empty() &&
+      !session->_logicScheduled.exchange(true, std::memory_order_acq_rel)) {
+    pushRunnable(index, std::move(session), false);
+  }
+}
+
+void LogicSystem::stealLoop(std::size_t index) {
+  std::shared_ptr<CSession> session;
+  while (true) {
+    if (popRunnable(index, session) || stealRunnable(index, session)) {
+      runSession(index, session);
+      session.reset();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(_idleMutex);
+    // 先登记为睡眠再检查一次，投递方看到登记后会在 _idleMutex 下唤醒
+    ++_sleepers;
+    if (!hasRunnable()) {
+      // 关闭状态且没有待处理的会话 退出循环
+      if (_isStop) {
+        --_sleepers;
+        break;
+      }
+      _idleCv.wait(lock);
+    }
+    --_sleepers;
+  }
+}
+
+LogicSystem::~LogicSystem() { stop(); }
+
+void LogicSystem::stop() {
+  if (_isStop.exchange(true)) {
+    return;
+  }
+  // 先停执行池，池中的消息处理完后再停逻辑线程
+  std::fill(_msgPools.begin(), _msgPools.end(), nullptr);
+  for (auto &pool : _pools) {
+    pool->stop();
+    _stoppedPoolStats.push_back(pool->stats());
+  }
+  _pools.clear();
+  if (_watchdogThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(_watchdogMutex);
+    }
+    _watchdogCv.notify_one();
+    _watchdogThread.join();
+  }
+  for (auto &shard : _shards) {
+    // 加锁后再通知，避免工作线程检查完 _isStop 后错过唤醒
+    std::lock_guard<std::mutex> lock(shard->_mutex);
+  }
+  {
+    std::lock_guard<std::mutex> lock(_idleMutex);
+  }
+  _idleCv.notify_all();
+  /*唤醒所有消费者线程*/
+  for (auto &shard : _shards) {
+    shard->_cv.notify_one();
+    if (shard->_workerThread.joinable()) {
+      shard->_workerThread.join();
+    }
+  }
+}
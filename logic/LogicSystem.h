@@ -1,35 +1,195 @@
 #pragma once
 #include "CSession.h"
-#include "Singleton.h"
+#include "DispatchTable.h"
+#include "ExecPool.h"
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <map>
 #include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
-#include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
-using funCallBack =
-    function<void(std::shared_ptr<CSession>, const short &msg_id,
-                  const std::string &msg_data)>;
+// 消息回调表：按消息 id 下标，回调参数为 (会话, 消息id, 消息体视图, 消息节点)。
+// 消息体视图直接指向接收块，只在回调执行期间有效；
+// 需要更久持有数据时保存消息节点的 shared_ptr 即可，无需拷贝
+using CallBackTable =
+    DispatchTable<const std::shared_ptr<CSession> &, short, boost::string_view,
+                  const std::shared_ptr<RecvNode> &>;
 
-class LogicSystem : public Singleton<LogicSystem> {
-  friend class Singleton<LogicSystem>;
+// 流式消息处理器：消息体按接收到的分片依次交给处理器，不在内存中拼出整条消息。
+// 每条流式消息创建一个处理器，各事件在会话所属的逻辑线程上按序调用，
+// onEnd 或 onAbort 之后处理器被销毁
+class StreamHandler {
 public:
+  virtual ~StreamHandler() = default;
+  virtual void onBegin(const std::shared_ptr<CSession> &session, short msgID,
+                       std::uint32_t totalLen) {}
+  // chunk 指向接收块，只在回调期间有效；需要更久持有时保存 node
+  virtual void onChunk(const std::shared_ptr<CSession> &session,
+                       boost::string_view chunk,
+                       const std::shared_ptr<RecvNode> &node) = 0;
+  virtual void onEnd(const std::shared_ptr<CSession> &session) {}
+  // 连接在消息中途断开
+  virtual void onAbort(const std::shared_ptr<CSession> &session) {}
+};
+
+using StreamHandlerFactory = std::function<std::unique_ptr<StreamHandler>()>;
+
+// 逻辑层，由 Runtime 创建和持有。
+// LOGIC_THREADED 模式下消息投递到逻辑线程处理，会话固定在一个线程上；
+// LOGIC_PER_CORE 模式下不启动逻辑线程，投递即在调用方所在的 io 线程上直接处理，
+// 投递只能在会话所属的 io 线程上调用；
+// LOGIC_WORK_STEALING 模式下消息进入会话自己的邮箱，有消息的会话作为一个任务
+// 放入逻辑线程的运行队列，空闲线程从忙碌线程的队列中窃取会话。
+// 各模式下同一会话的消息都按顺序、同一时刻只在一个线程上处理。
+// 绑定到执行池的消息 id 不走上述路径，在池的线程上处理，
+// 同一会话内这些 id 的消息之间保持顺序，与其他 id 的消息之间不保证
+// 开启 LOGIC_INLINE_HANDLERS 时，标记为非阻塞的消息 id 由 io 线程解析出后
+// 直接调用回调（dispatchInline）；会话还有消息在逻辑层排队时仍按序排队
+class LogicSystem {
+public:
+  // coreNum 为 io 线程数，workerNum 为逻辑线程数（0 表示 CPU 核心数），
+  // LOGIC_PER_CORE 模式下不使用 workerNum
+  LogicSystem(LOGIC_MODE mode, std::size_t coreNum,
+              std::size_t workerNum = LOGIC_WORKER_NUM);
   ~LogicSystem();
+  // 处理完已投递的消息后停止并等待执行池、逻辑线程和看门狗线程退出，
+  // 可重复调用。之后不能再投递消息
+  void stop();
+  LogicSystem(const LogicSystem &) = delete;
+  LogicSystem &operator=(const LogicSystem &) = delete;
   void postMsgToQueue(std::shared_ptr<LogicNode> msg);
+  // 批量投递同一会话的多条消息，只加一次锁；投递后 msgs 被清空
+  void postMsgsToQueue(std::vector<std::shared_ptr<LogicNode>> &msgs);
+  LOGIC_MODE getMode() const;
+  // 是否为该 id 注册了流式处理器，io 线程解析时调用
+  bool isStreamMsg(short msgID) const;
+  // 是否为非阻塞的消息 id，io 线程解析时调用
+  bool isInlineMsg(short msgID) const;
+  // 在当前 io 线程上直接调用 msgID 的回调，只用于 isInlineMsg 为 true 的 id
+  void dispatchInline(const std::shared_ptr<CSession> &session,
+                      const std::shared_ptr<RecvNode> &recvNode);
+  // 执行超过 LOGIC_INLINE_WARN_US 的内联回调次数（看门狗开启时统计）
+  std::uint64_t getInlineOverruns() const;
+  // 入站积压：所有会话已交给逻辑层尚未处理完的消息数，由 LogicNode 按会话
+  // 所属的 io 线程分别记账。LOGIC_PER_CORE 模式下消息在投递时即处理完，
+  // 不做全局记账，只受每个会话的上限约束，各核心之间不共享计数
+  void addPending(std::size_t core);
+  void finishPending(std::size_t core);
+  // 超过 LOGIC_TOTAL_PENDING_MAX 时为 true，会话应暂停读取。
+  // 每次调用汇总各核心的计数，并顺带更新峰值
+  bool isOverloaded();
+  // 因全局积压暂停读取的会话登记在此，积压回落到 LOGIC_TOTAL_PENDING_LOW
+  // 以下时逐个恢复；只保存弱引用，不延长会话的生命周期
+  void parkSession(const std::shared_ptr<CSession> &session);
+  std::size_t getPendingMsgs() const;
+  // 在 isOverloaded 时采样的峰值
+  std::size_t getPeakPendingMsgs() const;
+  // LOGIC_WORK_STEALING 模式下从其他线程窃取会话的次数
+  std::uint64_t getStealCount() const;
+  // 各执行池的统计；stop 之后返回执行池排空时的快照
+  std::vector<ExecPool::Stats> poolStats() const;
+
 private:
-  LogicSystem();
+  // 逻辑分片：每个分片有独立的队列、锁、条件变量和工作线程。
+  // LOGIC_THREADED 模式下同一会话的消息总是投递到同一分片的 _msgQueue；
+  // LOGIC_WORK_STEALING 模式下分片的 _runQueue 存放待运行的会话，
+  // 本线程从队头取，窃取者从队尾取走一半
+  struct LogicShard {
+    // 工作线程每次整体交换出队列，容量在两边复用
+    std::vector<std::shared_ptr<LogicNode>> _msgQueue;
+    std::deque<std::shared_ptr<CSession>> _runQueue;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::thread _workerThread;
+  };
+
   void regCallBack();
-  void helloWorldCallBack(std::shared_ptr<CSession>, const short &msg_id,
-                          const std::string &msg_data);
-  void dealMsg();
-  std::queue<std::shared_ptr<LogicNode>> _msgQueue;
-  std::mutex _mutex;
-  std::condition_variable _cv;
-  std::thread _workerThread;
-  bool _isStop;
-  std::map<short, funCallBack> _funCallBacks;
-};
\ No newline at end of file
+  void regStreamHandler(short msgID, StreamHandlerFactory factory);
+  // 标记 msgID 的回调为非阻塞（只做少量计算、不加锁等待、不做阻塞 io），
+  // 可以在 io 线程上直接执行。流式消息和绑定执行池的 id 不能内联
+  void markNonBlocking(short msgID);
+  // 看门狗线程：检查各 io 线程上仍在执行的内联回调
+  void watchdogLoop();
+  // 恢复所有登记的会话
+  void wakeParked();
+  void addPool(const std::string &name, std::size_t threads,
+               std::size_t queueLimit);
+  // 把消息 id 的处理交给名为 name 的执行池，需先 addPool
+  void bindPool(short msgID, const std::string &name);
+  // 把 msgs 中绑定了执行池的消息投递到池中并移出 msgs
+  void postToPools(std::vector<std::shared_ptr<LogicNode>> &msgs);
+  void helloWorldCallBack(const std::shared_ptr<CSession> &, short msg_id,
+                          boost::string_view msg_data,
+                          const std::shared_ptr<RecvNode> &msg_node);
+  void unknownMsgCallBack(const std::shared_ptr<CSession> &, short msg_id,
+                          boost::string_view msg_data,
+                          const std::shared_ptr<RecvNode> &msg_node);
+  void dealMsg(LogicShard &shard);
+  void dispatchMsg(const std::shared_ptr<LogicNode> &msgNode);
+  void dispatchStream(const std::shared_ptr<LogicNode> &msgNode);
+  static std::size_t sessionKey(const std::shared_ptr<CSession> &session);
+  std::size_t selectShard(const std::shared_ptr<CSession> &session) const;
+  // LOGIC_PER_CORE 模式下在当前 io 线程上直接处理
+  void dispatchLocal(const std::shared_ptr<LogicNode> &msgNode);
+  // LOGIC_WORK_STEALING 模式
+  void postToMailbox(std::vector<std::shared_ptr<LogicNode>> &msgs);
+  void pushRunnable(std::size_t index, std::shared_ptr<CSession> session,
+                    bool external);
+  bool popRunnable(std::size_t index, std::shared_ptr<CSession> &session);
+  bool stealRunnable(std::size_t index, std::shared_ptr<CSession> &session);
+  bool hasRunnable();
+  void runSession(std::size_t index, std::shared_ptr<CSession> &session);
+  void stealLoop(std::size_t index);
+
+  LOGIC_MODE _mode;
+  std::size_t _coreNum;
+  std::vector<std::unique_ptr<LogicShard>> _shards;
+  std::atomic<bool> _isStop;
+  CallBackTable _funCallBacks;
+  // 按消息 id 下标，非空表示该 id 按流式接收
+  std::vector<StreamHandlerFactory> _streamFactories;
+  // LOGIC_WORK_STEALING 模式下所有空闲线程在同一个条件变量上等待
+  std::mutex _idleMutex;
+  std::condition_variable _idleCv;
+  std::atomic<std::size_t> _sleepers;
+  std::atomic<std::uint64_t> _steals;
+  std::vector<std::unique_ptr<ExecPool>> _pools;
+  // stop 时各执行池处理完剩余消息后的统计
+  std::vector<ExecPool::Stats> _stoppedPoolStats;
+  // 按消息 id 下标，非空表示该 id 在对应的执行池中处理
+  std::vector<ExecPool *> _msgPools;
+  // 按消息 id 下标，非 0 表示回调在 io 线程上直接执行
+  std::vector<char> _inlineMsgs;
+  // 每个 io 线程正在执行的内联回调：开始时间（steady_clock 纳秒，0 表示空闲）
+  // 和消息 id，由所属 io 线程写、看门狗线程读
+  struct InlineSlot {
+    std::atomic<std::int64_t> _start;
+    std::atomic<short> _msgID;
+    // 看门狗已报告过的开始时间，同一次执行只报告一次，只由看门狗线程访问
+    std::int64_t _reported;
+    char _pad[64];
+  };
+  std::vector<std::unique_ptr<InlineSlot>> _inlineSlots;
+  std::atomic<std::uint64_t> _inlineOverruns;
+  std::mutex _watchdogMutex;
+  std::condition_variable _watchdogCv;
+  std::thread _watchdogThread;
+  // 下标为 io 线程。计数只由该核心上的会话增减，各核心不共享缓存行
+  struct PendingSlot {
+    std::atomic<std::size_t> _count;
+    char _pad[64];
+  };
+  std::vector<std::unique_ptr<PendingSlot>> _pendingSlots;
+  // 只在峰值增长时写入
+  std::atomic<std::size_t> _peakPendingMsgs;
+  std::mutex _parkedMutex;
+  std::vector<std::weak_ptr<CSession>> _parked;
+  // _parked 非空时为 true，处理消息的线程据此判断是否需要加锁
+  std::atomic<bool> _hasParked;
+};
@@ -0,0 +1,285 @@
+#include "MemoryPool.h"
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+// 每个线程每个尺寸等级的空闲块缓存，只由所属线程读写；
+// 统计计数器只有所属线程写，其他线程读取汇总，因此用 relaxed 原子即可
+class MemoryPool::ThreadCache {
+public:
+  explicit ThreadCache(MemoryPool &pool) : _pool(pool) {
+    _pool.registerCache(this);
+  }
+  ~ThreadCache();
+
+  struct Bucket {
+    FreeBlock *head = nullptr;
+    std::size_t count = 0;
+  };
+
+  static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+  }
+
+  // 借出量变化攒够一批才汇入全局计数，避免每次分配都写共享的原子变量
+  void trackInUse(std::int64_t delta) {
+    _pendingInUse += delta;
+    if (_pendingInUse >= PEAK_FLUSH_BYTES ||
+        _pendingInUse <= -PEAK_FLUSH_BYTES) {
+      _pool.addInUse(_pendingInUse);
+      _pendingInUse = 0;
+    }
+  }
+
+  MemoryPool &_pool;
+  std::array<Bucket, CLASS_NUM> _buckets;
+  std::atomic<std::uint64_t> _hits{0};
+  std::atomic<std::uint64_t> _misses{0};
+  std::atomic<std::uint64_t> _allocBytes{0};
+  std::atomic<std::uint64_t> _freeBytes{0};
+  std::int64_t _pendingInUse = 0;
+};
+
+namespace {
+// 线程缓存析构后（线程退出阶段）仍可能有释放，此时直接走全局链表
+thread_local MemoryPool::ThreadCache *t_cache = nullptr;
+thread_local bool t_cacheDestroyed = false;
+} // namespace
+
+MemoryPool::ThreadCache::~ThreadCache() {
+  for (std::size_t i = 0; i < CLASS_NUM; ++i) {
+    Bucket &bucket = _buckets[i];
+    if (bucket.head == nullptr) {
+      continue;
+    }
+    FreeBlock *tail = bucket.head;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    _pool.releaseToCentral(bucket.head, tail, i);
+    bucket.head = nullptr;
+    bucket.count = 0;
+  }
+  _pool.addInUse(_pendingInUse);
+  _pool.unregisterCache(this);
+  t_cache = nullptr;
+  t_cacheDestroyed = true;
+}
+
+MemoryPool &MemoryPool::instance() {
+  // 放在静态存储上满足缓存行对齐，placement new 后不调用析构
+  static std::aligned_storage<sizeof(MemoryPool), alignof(MemoryPool)>::type
+      storage;
+  static MemoryPool *pool = new (&storage) MemoryPool;
+  return *pool;
+}
+
+std::size_t MemoryPool::classIndex(std::size_t size) {
+  std::size_t index = 0;
+  std::size_t blockSize = MIN_BLOCK_SIZE;
+  while (blockSize < size) {
+    blockSize <<= 1;
+    ++index;
+  }
+  return index;
+}
+
+std::size_t MemoryPool::classSize(std::size_t index) {
+  return MIN_BLOCK_SIZE << index;
+}
+
+std::size_t MemoryPool::batchSize(std::size_t index) {
+  // 每批约 32KB，大块至少一块
+  return std::max<std::size_t>(1, (32 * 1024) / classSize(index));
+}
+
+MemoryPool::ThreadCache *MemoryPool::localCache() {
+  if (t_cache != nullptr) {
+    return t_cache;
+  }
+  if (t_cacheDestroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache(*this);
+  t_cache = &cache;
+  return t_cache;
+}
+
+void *MemoryPool::allocate(std::size_t size) {
+  if (size > MAX_BLOCK_SIZE) {
+    return ::operator new(size);
+  }
+  std::size_t index = classIndex(size);
+  ThreadCache *cache = localCache();
+  if (cache != nullptr) {
+    ThreadCache::bump(cache->_allocBytes, classSize(index));
+    cache->trackInUse(static_cast<std::int64_t>(classSize(index)));
+    ThreadCache::Bucket &bucket = cache->_buckets[index];
+    if (bucket.head != nullptr) {
+      FreeBlock *block = bucket.head;
+      bucket.head = block->next;
+      --bucket.count;
+      ThreadCache::bump(cache->_hits, 1);
+      return block;
+    }
+  } else {
+    _orphanAllocBytes.fetch_add(classSize(index), std::memory_order_relaxed);
+    addInUse(static_cast<std::int64_t>(classSize(index)));
+  }
+  return allocateFromCentral(cache, index);
+}
+
+void *MemoryPool::allocateFromCentral(ThreadCache *cache, std::size_t index) {
+  CentralList &central = _central[index];
+  FreeBlock *block = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(central.mutex);
+    block = central.head;
+    if (block != nullptr) {
+      // 取一块返回，再顺带搬一批到线程缓存
+      central.head = block->next;
+      if (cache != nullptr) {
+        ThreadCache::Bucket &bucket = cache->_buckets[index];
+        std::size_t batch = batchSize(index);
+        while (central.head != nullptr && bucket.count < batch) {
+          FreeBlock *next = central.head->next;
+          central.head->next = bucket.head;
+          bucket.head = central.head;
+          ++bucket.count;
+          central.head = next;
+        }
+      }
+    }
+  }
+  if (block != nullptr) {
+    if (cache != nullptr) {
+      ThreadCache::bump(cache->_hits, 1);
+    } else {
+      _orphanHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    return block;
+  }
+  if (cache != nullptr) {
+    ThreadCache::bump(cache->_misses, 1);
+  } else {
+    _orphanMisses.fetch_add(1, std::memory_order_relaxed);
+  }
+  _reservedBytes.fetch_add(classSize(index), std::memory_order_relaxed);
+  return ::operator new(classSize(index));
+}
+
+void MemoryPool::deallocate(void *ptr, std::size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (size > MAX_BLOCK_SIZE) {
+    ::operator delete(ptr);
+    return;
+  }
+  std::size_t index = classIndex(size);
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  ThreadCache *cache = localCache();
+  if (cache == nullptr) {
+    _orphanFreeBytes.fetch_add(classSize(index), std::memory_order_relaxed);
+    addInUse(-static_cast<std::int64_t>(classSize(index)));
+    block->next = nullptr;
+    releaseToCentral(block, block, index);
+    return;
+  }
+  ThreadCache::bump(cache->_freeBytes, classSize(index));
+  cache->trackInUse(-static_cast<std::int64_t>(classSize(index)));
+  ThreadCache::Bucket &bucket = cache->_buckets[index];
+  block->next = bucket.head;
+  bucket.head = block;
+  ++bucket.count;
+  // 缓存超过两批时归还一批，防止生产者线程无限囤积
+  std::size_t batch = batchSize(index);
+  if (bucket.count > 2 * batch) {
+    FreeBlock *head = bucket.head;
+    FreeBlock *tail = head;
+    for (std::size_t i = 1; i < batch; ++i) {
+      tail = tail->next;
+    }
+    bucket.head = tail->next;
+    bucket.count -= batch;
+    releaseToCentral(head, tail, index);
+  }
+}
+
+void MemoryPool::releaseToCentral(FreeBlock *head, FreeBlock *tail,
+                                  std::size_t index) {
+  CentralList &central = _central[index];
+  std::lock_guard<std::mutex> lock(central.mutex);
+  tail->next = central.head;
+  central.head = head;
+}
+
+void MemoryPool::addInUse(std::int64_t delta) {
+  std::int64_t inUse =
+      _inUseBytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+  std::int64_t peak = _peakInUseBytes.load(std::memory_order_relaxed);
+  while (inUse > peak && !_peakInUseBytes.compare_exchange_weak(
+                             peak, inUse, std::memory_order_relaxed)) {
+  }
+}
+
+void MemoryPool::registerCache(ThreadCache *cache) {
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  _caches.push_back(cache);
+}
+
+void MemoryPool::unregisterCache(ThreadCache *cache) {
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  _retiredHits += cache->_hits.load(std::memory_order_relaxed);
+  _retiredMisses += cache->_misses.load(std::memory_order_relaxed);
+  _retiredInUse +=
+      static_cast<std::int64_t>(cache->_allocBytes.load(std::memory_order_relaxed)) -
+      static_cast<std::int64_t>(cache->_freeBytes.load(std::memory_order_relaxed));
+  _caches.erase(std::remove(_caches.begin(), _caches.end(), cache),
+                _caches.end());
+}
+
+MemoryPool::Stats MemoryPool::stats() {
+  std::lock_guard<std::mutex> lock(_statsMutex);
+  Stats stats;
+  stats.hits = _retiredHits + _orphanHits.load(std::memory_order_relaxed);
+  stats.misses = _retiredMisses + _orphanMisses.load(std::memory_order_relaxed);
+  // 块可能在一个线程分配、另一个线程释放，汇总后才是真实借出量
+  std::int64_t inUse =
+      _retiredInUse +
+      static_cast<std::int64_t>(
+          _orphanAllocBytes.load(std::memory_order_relaxed)) -
+      static_cast<std::int64_t>(
+          _orphanFreeBytes.load(std::memory_order_relaxed));
+  for (ThreadCache *cache : _caches) {
+    stats.hits += cache->_hits.load(std::memory_order_relaxed);
+    stats.misses += cache->_misses.load(std::memory_order_relaxed);
+    inUse += static_cast<std::int64_t>(
+                 cache->_allocBytes.load(std::memory_order_relaxed)) -
+             static_cast<std::int64_t>(
+                 cache->_freeBytes.load(std::memory_order_relaxed));
+  }
+  stats.inUseBytes = inUse > 0 ? static_cast<std::uint64_t>(inUse) : 0;
+  stats.reservedBytes = _reservedBytes.load(std::memory_order_relaxed);
+  // 分批汇入的峰值可能略低于此刻精确汇总的借出量
+  std::int64_t peak =
+      std::max(_peakInUseBytes.load(std::memory_order_relaxed), inUse);
+  stats.peakInUseBytes = peak > 0 ? static_cast<std::uint64_t>(peak) : 0;
+  return stats;
+}
+
+namespace {
+struct PoolBufferDeleter {
+  std::size_t size;
+  void operator()(char *ptr) const {
+    MemoryPool::instance().deallocate(ptr, size);
+  }
+};
+} // namespace
+
+std::shared_ptr<char> makePoolBuffer(std::size_t size) {
+  char *data = static_cast<char *>(MemoryPool::instance().allocate(size));
+  return std::shared_ptr<char>(data, PoolBufferDeleter{size},
+                               PoolAllocator<char>());
+}
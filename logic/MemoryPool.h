@@ -0,0 +1,119 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 按大小分级的内存池：64B ~ 64KB 共 11 个尺寸等级。
+// 每个线程有自己的空闲块缓存，只有缓存空了或满了才批量地和全局空闲链表交换，
+// 因此高频的消息分配/释放基本不争锁，也不进入 malloc。
+// 超过最大等级的请求直接走 operator new。
+class MemoryPool {
+public:
+  static constexpr std::size_t MIN_BLOCK_SIZE = 64;
+  static constexpr std::size_t MAX_BLOCK_SIZE = 64 * 1024;
+  static constexpr std::size_t CLASS_NUM = 11;
+  // 线程缓存攒够这么多借出量的变化才汇入全局计数，峰值的误差不超过
+  // 线程数乘以该值
+  static constexpr std::int64_t PEAK_FLUSH_BYTES = 64 * 1024;
+
+  struct Stats {
+    std::uint64_t hits;       // 由空闲块满足的分配次数
+    std::uint64_t misses;     // 需要向系统申请的分配次数
+    std::uint64_t inUseBytes; // 当前借出的字节数
+    std::uint64_t reservedBytes; // 池累计从系统申请的字节数，池不归还内存，只增不减
+    std::uint64_t peakInUseBytes; // 借出字节数的历史最高值
+    double hitRate() const {
+      return hits + misses == 0 ? 0.0
+                                : static_cast<double>(hits) / (hits + misses);
+    }
+  };
+
+  // 进程退出时其他单例的析构仍可能归还内存，池本身有意不析构
+  static MemoryPool &instance();
+
+  void *allocate(std::size_t size);
+  void deallocate(void *ptr, std::size_t size);
+  Stats stats();
+
+  class ThreadCache;
+
+private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+  // 全局空闲链表，按缓存行对齐避免不同等级之间伪共享
+  struct alignas(64) CentralList {
+    std::mutex mutex;
+    FreeBlock *head = nullptr;
+  };
+
+  MemoryPool() = default;
+  static std::size_t classIndex(std::size_t size);
+  static std::size_t classSize(std::size_t index);
+  // 一次在线程缓存和全局链表之间搬运的块数
+  static std::size_t batchSize(std::size_t index);
+  ThreadCache *localCache();
+  void *allocateFromCentral(ThreadCache *cache, std::size_t index);
+  void releaseToCentral(FreeBlock *head, FreeBlock *tail, std::size_t index);
+  void registerCache(ThreadCache *cache);
+  void unregisterCache(ThreadCache *cache);
+  // 把借出量的变化汇入全局计数并更新峰值
+  void addInUse(std::int64_t delta);
+
+  std::array<CentralList, CLASS_NUM> _central;
+  std::atomic<std::uint64_t> _reservedBytes{0};
+  // 线程缓存已析构（线程退出阶段）时的分配和释放，直接记在池上
+  std::atomic<std::uint64_t> _orphanHits{0};
+  std::atomic<std::uint64_t> _orphanMisses{0};
+  std::atomic<std::uint64_t> _orphanAllocBytes{0};
+  std::atomic<std::uint64_t> _orphanFreeBytes{0};
+  // 各线程分批汇入的借出量，只用来维护峰值；当前借出量仍按线程计数汇总
+  std::atomic<std::int64_t> _inUseBytes{0};
+  std::atomic<std::int64_t> _peakInUseBytes{0};
+  std::mutex _statsMutex;
+  std::vector<ThreadCache *> _caches;
+  // 已退出线程的统计
+  std::uint64_t _retiredHits = 0;
+  std::uint64_t _retiredMisses = 0;
+  std::int64_t _retiredInUse = 0;
+};
+
+// 从内存池分配的 STL 分配器，用于 allocate_shared 让控制块和对象一起落在池中
+template <class T> class PoolAllocator {
+public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+  template <class U> PoolAllocator(const PoolAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(MemoryPool::instance().allocate(n * sizeof(T)));
+  }
+  void deallocate(T *ptr, std::size_t n) {
+    MemoryPool::instance().deallocate(ptr, n * sizeof(T));
+  }
+};
+
+template <class T, class U>
+bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &) {
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &) {
+  return false;
+}
+
+// 对象和 shared_ptr 控制块都从内存池分配
+template <class T, class... Args>
+std::shared_ptr<T> makePoolShared(Args &&...args) {
+  return std::allocate_shared<T>(PoolAllocator<T>(),
+                                 std::forward<Args>(args)...);
+}
+
+// 从内存池分配一块引用计数的字符缓冲区，最后一个引用释放时归还
+std::shared_ptr<char> makePoolBuffer(std::size_t size);
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// 无锁多生产者单消费者队列（Vyukov 算法）。
+// push 只做一次原子交换，任意线程可调用且不会阻塞；
+// pop/empty 只能由唯一的消费者线程调用。
+// 生产者交换完 _head 但尚未链接 next 的瞬间，消费者会看到队列为空，
+// 调用方需要在生产者 push 之后再做一次通知（见 CSession 的 _writing 标志）。
+template <class T, class Alloc = std::allocator<T>> class MpscQueue {
+  struct Node {
+    Node() : next(nullptr) {}
+    explicit Node(T &&v) : next(nullptr), value(std::move(v)) {}
+    std::atomic<Node *> next;
+    T value;
+  };
+  using NodeAlloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+public:
+  MpscQueue() : _head(nullptr), _tail(nullptr) {
+    Node *stub = newNode();
+    _head.store(stub, std::memory_order_relaxed);
+    _tail = stub;
+  }
+
+  ~MpscQueue() {
+    T value;
+    while (pop(value)) {
+    }
+    deleteNode(_tail);
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  void push(T value) {
+    Node *node = newNode(std::move(value));
+    Node *prev = _head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  bool pop(T &value) {
+    Node *tail = _tail;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    value = std::move(next->value);
+    _tail = next;
+    deleteNode(tail);
+    return true;
+  }
+
+  bool empty() const {
+    return _tail->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  template <class... Args> Node *newNode(Args &&...args) {
+    Node *node = NodeTraits::allocate(_alloc, 1);
+    NodeTraits::construct(_alloc, node, std::forward<Args>(args)...);
+    return node;
+  }
+
+  void deleteNode(Node *node) {
+    NodeTraits::destroy(_alloc, node);
+    NodeTraits::deallocate(_alloc, node, 1);
+  }
+
+  NodeAlloc _alloc;
+  // 生产者写 _head，消费者写 _tail，中间填充避免伪共享
+  std::atomic<Node *> _head;
+  char _pad[64];
+  Node *_tail;
+};
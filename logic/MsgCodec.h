@@ -0,0 +1,362 @@
+#pragma once
+#include "const.h"
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// 消息体编解码。消息结构体用 MSG_FIELDS 声明字段，同一份声明同时生成
+// 紧凑二进制编码和 JSON 编码，按 const.h 中 msgCodec(msgID) 选择其一：
+//
+//   struct HelloWorldMsg {
+//     int id;
+//     std::string data;
+//     MSG_FIELDS(MSG_FIELD(id) MSG_FIELD(data))
+//   };
+//
+// 二进制格式按字段声明顺序排列，不带字段名：
+//   整数  -> varint（有符号先 zigzag）
+//   bool  -> 1 字节
+//   浮点  -> 小端定长
+//   字符串/数组 -> varint 长度 + 内容
+//   嵌套结构体 -> 按其字段依次编码
+// 新字段只能追加在末尾；解码时顶层数据提前结束，剩余字段保持默认值，
+// 嵌套结构体（包括数组元素）内部提前结束则解码失败。
+#define MSG_FIELD(name) visitor(#name, name);
+#define MSG_FIELDS(...)                                                        \
+  template <class Visitor> void visitFields(Visitor &visitor) {                \
+    __VA_ARGS__                                                                \
+  }                                                                            \
+  template <class Visitor> void visitFields(Visitor &visitor) const {          \
+    __VA_ARGS__                                                                \
+  }
+
+namespace msgcodec {
+
+// 判断类型是否用 MSG_FIELDS 声明了字段
+template <class T> class HasFields {
+  struct Probe {
+    template <class U> void operator()(const char *, const U &) {}
+  };
+  template <class U>
+  static std::true_type test(
+      decltype(std::declval<const U &>().visitFields(std::declval<Probe &>())) *);
+  template <class U> static std::false_type test(...);
+
+public:
+  static constexpr bool value = decltype(test<T>(nullptr))::value;
+};
+
+class BinaryWriter {
+public:
+  explicit BinaryWriter(std::string &out) : _out(out) {}
+
+  template <class T> void operator()(const char *, const T &value) {
+    write(value);
+  }
+
+  void writeVarint(std::uint64_t value) {
+    while (value >= 0x80) {
+      _out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    _out.push_back(static_cast<char>(value));
+  }
+
+  void write(bool value) { _out.push_back(value ? 1 : 0); }
+
+  template <class T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                          std::is_signed<T>::value>::type
+  write(T value) {
+    std::int64_t v = value;
+    writeVarint((static_cast<std::uint64_t>(v) << 1) ^
+                static_cast<std::uint64_t>(v >> 63));
+  }
+
+  template <class T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                          std::is_unsigned<T>::value>::type
+  write(T value) {
+    writeVarint(value);
+  }
+
+  template <class T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type
+  write(T value) {
+    // 只支持小端主机
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    _out.append(bytes, sizeof(T));
+  }
+
+  void write(const std::string &value) {
+    writeVarint(value.size());
+    _out.append(value);
+  }
+
+  template <class T> void write(const std::vector<T> &values) {
+    writeVarint(values.size());
+    for (const T &value : values) {
+      write(value);
+    }
+  }
+
+  template <class T>
+  typename std::enable_if<HasFields<T>::value>::type write(const T &value) {
+    value.visitFields(*this);
+  }
+
+private:
+  std::string &_out;
+};
+
+class BinaryReader {
+public:
+  explicit BinaryReader(boost::string_view in)
+      : _pos(in.data()), _end(in.data() + in.size()), _ok(true), _depth(0) {}
+
+  template <class T> void operator()(const char *, T &value) {
+    if (!_ok) {
+      return;
+    }
+    if (_pos == _end) {
+      // 顶层数据结束后的字段保持默认值，兼容追加字段前的旧数据；
+      // 嵌套结构体已开始解码却提前结束，说明数据被截断
+      if (_depth > 0) {
+        fail();
+      }
+      return;
+    }
+    read(value);
+  }
+
+  bool ok() const { return _ok; }
+
+  bool readVarint(std::uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (_pos == _end) {
+        return fail();
+      }
+      std::uint8_t byte = static_cast<std::uint8_t>(*_pos++);
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return fail();
+  }
+
+  void read(bool &value) {
+    if (_pos == _end) {
+      fail();
+      return;
+    }
+    value = *_pos++ != 0;
+  }
+
+  template <class T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                          std::is_signed<T>::value>::type
+  read(T &value) {
+    std::uint64_t v = 0;
+    if (readVarint(v)) {
+      value = static_cast<T>(static_cast<std::int64_t>(v >> 1) ^
+                             -static_cast<std::int64_t>(v & 1));
+    }
+  }
+
+  template <class T>
+  typename std::enable_if<std::is_integral<T>::value &&
+                          std::is_unsigned<T>::value>::type
+  read(T &value) {
+    std::uint64_t v = 0;
+    if (readVarint(v)) {
+      value = static_cast<T>(v);
+    }
+  }
+
+  template <class T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type
+  read(T &value) {
+    if (static_cast<std::size_t>(_end - _pos) < sizeof(T)) {
+      fail();
+      return;
+    }
+    std::memcpy(&value, _pos, sizeof(T));
+    _pos += sizeof(T);
+  }
+
+  void read(std::string &value) {
+    std::uint64_t len = 0;
+    if (!readVarint(len)) {
+      return;
+    }
+    if (len > static_cast<std::uint64_t>(_end - _pos)) {
+      fail();
+      return;
+    }
+    value.assign(_pos, static_cast<std::size_t>(len));
+    _pos += len;
+  }
+
+  template <class T> void read(std::vector<T> &values) {
+    std::uint64_t count = 0;
+    if (!readVarint(count)) {
+      return;
+    }
+    // 每个元素至少一个字节，防止恶意长度导致超大分配
+    if (count > static_cast<std::uint64_t>(_end - _pos)) {
+      fail();
+      return;
+    }
+    values.resize(static_cast<std::size_t>(count));
+    for (T &value : values) {
+      read(value);
+      if (!_ok) {
+        return;
+      }
+    }
+  }
+
+  template <class T>
+  typename std::enable_if<HasFields<T>::value>::type read(T &value) {
+    // 嵌套结构体内部字段必须完整，缺少字段时整个解码失败
+    ++_depth;
+    value.visitFields(*this);
+    --_depth;
+  }
+
+private:
+  bool fail() {
+    _ok = false;
+    return false;
+  }
+
+  const char *_pos;
+  const char *_end;
+  bool _ok;
+  // 正在解码的嵌套结构体层数，0 表示顶层
+  int _depth;
+};
+
+class JsonWriter {
+public:
+  explicit JsonWriter(nlohmann::json &js) : _js(js) {}
+
+  template <class T> void operator()(const char *name, const T &value) {
+    _js[name] = toJson(value);
+  }
+
+  template <class T>
+  static typename std::enable_if<!HasFields<T>::value, nlohmann::json>::type
+  toJson(const T &value) {
+    return nlohmann::json(value);
+  }
+
+  template <class T>
+  static typename std::enable_if<HasFields<T>::value, nlohmann::json>::type
+  toJson(const T &value) {
+    nlohmann::json js = nlohmann::json::object();
+    JsonWriter writer(js);
+    value.visitFields(writer);
+    return js;
+  }
+
+  template <class T>
+  static nlohmann::json toJson(const std::vector<T> &values) {
+    nlohmann::json js = nlohmann::json::array();
+    for (const T &value : values) {
+      js.push_back(toJson(value));
+    }
+    return js;
+  }
+
+private:
+  nlohmann::json &_js;
+};
+
+class JsonReader {
+public:
+  explicit JsonReader(const nlohmann::json &js) : _js(js) {}
+
+  template <class T> void operator()(const char *name, T &value) {
+    auto iter = _js.find(name);
+    if (iter != _js.end()) {
+      fromJson(*iter, value);
+    }
+  }
+
+  template <class T>
+  static typename std::enable_if<!HasFields<T>::value>::type
+  fromJson(const nlohmann::json &js, T &value) {
+    value = js.get<T>();
+  }
+
+  template <class T>
+  static typename std::enable_if<HasFields<T>::value>::type
+  fromJson(const nlohmann::json &js, T &value) {
+    JsonReader reader(js);
+    value.visitFields(reader);
+  }
+
+  template <class T>
+  static void fromJson(const nlohmann::json &js, std::vector<T> &values) {
+    values.resize(js.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      fromJson(js[i], values[i]);
+    }
+  }
+
+private:
+  const nlohmann::json &_js;
+};
+
+} // namespace msgcodec
+
+template <class T> void encodeBinary(const T &msg, std::string &out) {
+  msgcodec::BinaryWriter writer(out);
+  msg.visitFields(writer);
+}
+
+template <class T> bool decodeBinary(boost::string_view in, T &msg) {
+  msgcodec::BinaryReader reader(in);
+  msg.visitFields(reader);
+  return reader.ok();
+}
+
+template <class T> void encodeJson(const T &msg, std::string &out) {
+  out.append(msgcodec::JsonWriter::toJson(msg).dump());
+}
+
+template <class T> bool decodeJson(boost::string_view in, T &msg) {
+  nlohmann::json js = nlohmann::json::parse(in.begin(), in.end(), nullptr,
+                                            false);
+  if (js.is_discarded() || !js.is_object()) {
+    return false;
+  }
+  try {
+    msgcodec::JsonReader::fromJson(js, msg);
+  } catch (const nlohmann::json::exception &) {
+    return false;
+  }
+  return true;
+}
+
+// 按消息 id 配置的编码格式编解码
+template <class T> void encodeMsg(short msgID, const T &msg, std::string &out) {
+  if (msgCodec(msgID) == CODEC_BINARY) {
+    encodeBinary(msg, out);
+  } else {
+    encodeJson(msg, out);
+  }
+}
+
+template <class T> bool decodeMsg(short msgID, boost::string_view in, T &msg) {
+  return msgCodec(msgID) == CODEC_BINARY ? decodeBinary(in, msg)
+                                         : decodeJson(in, msg);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "MsgCodec.h"
+#include <cstdint>
+#include <string>
+
+// 各消息 id 的消息体定义，编码格式见 const.h 中的 msgCodec
+
+// MSG_HELLO_WORLD
+struct HelloWorldMsg {
+  int id = 0;
+  std::string data;
+  MSG_FIELDS(MSG_FIELD(id) MSG_FIELD(data))
+};
+
+// MSG_UPLOAD 的应答，请求消息体为任意字节流
+struct UploadAckMsg {
+  std::uint32_t size = 0;
+  // 消息体的 FNV-1a 校验值
+  std::uint32_t checksum = 0;
+  MSG_FIELDS(MSG_FIELD(size) MSG_FIELD(checksum))
+};
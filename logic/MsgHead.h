@@ -0,0 +1,113 @@
+#pragma once
+#include "const.h"
+#include <boost/asio/detail/socket_ops.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 消息头编解码，服务端和客户端共用。
+// 定长头：2 字节 id + 2 字节长度，网络字节序，长度上限 MAX_LENGTH；
+// 变长头：id 和长度依次为 LEB128 varint，小消息只需 2~3 字节，
+// 长度最大 32 位，具体上限由 msgMaxLength 按消息 id 配置。
+namespace msghead {
+
+inline std::size_t varintLen(std::uint32_t value) {
+  std::size_t len = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++len;
+  }
+  return len;
+}
+
+inline std::size_t writeVarint(char *out, std::uint32_t value) {
+  std::size_t len = 0;
+  while (value >= 0x80) {
+    out[len++] = static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out[len++] = static_cast<char>(value);
+  return len;
+}
+
+// 返回读取的字节数，0 表示数据不足，-1 表示超过 maxBytes 仍未结束
+inline int readVarint(const char *in, std::size_t avail, std::size_t maxBytes,
+                      std::uint32_t &value) {
+  std::uint64_t result = 0;
+  for (std::size_t i = 0; i < maxBytes; ++i) {
+    if (i == avail) {
+      return 0;
+    }
+    std::uint8_t byte = static_cast<std::uint8_t>(in[i]);
+    result |= static_cast<std::uint64_t>(byte & 0x7f) << (7 * i);
+    if (!(byte & 0x80)) {
+      if (result > 0xffffffffu) {
+        return -1;
+      }
+      value = static_cast<std::uint32_t>(result);
+      return static_cast<int>(i + 1);
+    }
+  }
+  return -1;
+}
+
+} // namespace msghead
+
+// 消息头字节数
+inline std::size_t headLen(HEAD_MODE mode, short msgID, std::uint32_t dataLen) {
+  if (mode == HEAD_FIXED) {
+    return HEAD_TOTAL_LEN;
+  }
+  return msghead::varintLen(static_cast<std::uint16_t>(msgID)) +
+         msghead::varintLen(dataLen);
+}
+
+// 写入消息头，out 至少要有 HEAD_VARINT_MAX_LEN 字节，返回写入的字节数
+inline std::size_t encodeHead(char *out, HEAD_MODE mode, short msgID,
+                              std::uint32_t dataLen) {
+  if (mode == HEAD_FIXED) {
+    short id = boost::asio::detail::socket_ops::host_to_network_short(msgID);
+    short len = boost::asio::detail::socket_ops::host_to_network_short(
+        static_cast<short>(dataLen));
+    std::memcpy(out, &id, HEAD_ID_LEN);
+    std::memcpy(out + HEAD_ID_LEN, &len, HEAD_DATA_LEN);
+    return HEAD_TOTAL_LEN;
+  }
+  std::size_t len =
+      msghead::writeVarint(out, static_cast<std::uint16_t>(msgID));
+  return len + msghead::writeVarint(out + len, dataLen);
+}
+
+// 解析消息头，返回头部字节数；0 表示数据不足，-1 表示头部格式非法。
+// 长度是否超限由调用方按 maxBodyLength 判断
+inline int decodeHead(const char *in, std::size_t avail, HEAD_MODE mode,
+                      short &msgID, std::uint32_t &dataLen) {
+  if (mode == HEAD_FIXED) {
+    if (avail < HEAD_TOTAL_LEN) {
+      return 0;
+    }
+    short id = 0;
+    short len = 0;
+    std::memcpy(&id, in, HEAD_ID_LEN);
+    std::memcpy(&len, in + HEAD_ID_LEN, HEAD_DATA_LEN);
+    msgID = boost::asio::detail::socket_ops::network_to_host_short(id);
+    // 负数长度按无符号解释，必然超过 MAX_LENGTH
+    dataLen = static_cast<std::uint16_t>(
+        boost::asio::detail::socket_ops::network_to_host_short(len));
+    return HEAD_TOTAL_LEN;
+  }
+  std::uint32_t id = 0;
+  int idLen = msghead::readVarint(in, avail, 3, id);
+  if (idLen <= 0) {
+    return idLen;
+  }
+  if (id > 0x7fff) {
+    return -1;
+  }
+  msgID = static_cast<short>(id);
+  int lenLen = msghead::readVarint(in + idLen, avail - idLen, 5, dataLen);
+  if (lenLen <= 0) {
+    return lenLen;
+  }
+  return idLen + lenLen;
+}
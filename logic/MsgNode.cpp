@@ -1,41 +1,75 @@
 #include "MsgNode.h"
+#include "Logger.h"
+#include "MemoryPool.h"
+#include "MsgHead.h"
 #include "const.h"
 #include <boost/asio.hpp>
-#include <iostream>
 
-MsgNode::MsgNode(short len) : _curLen(0), _totalLen(len) {
-  _data = new char[_totalLen + 1];
+MsgNode::MsgNode(std::uint32_t len) : _curLen(0), _totalLen(len) {
+  _data = static_cast<char *>(MemoryPool::instance().allocate(_totalLen + 1));
   _data[_totalLen] = '\0';
 }
 
+MsgNode::MsgNode(std::shared_ptr<char> chunk, char *data,
+                 std::uint32_t len)
+    : _curLen(len), _totalLen(len), _data(data), _chunk(std::move(chunk)) {}
+
 MsgNode::~MsgNode() {
-  std::cout << "destruct MsgNode" << std::endl;
-  if (_data) {
-    delete[] _data;
+  LOG_DEBUG("destruct MsgNode");
+  if (_data && !_chunk) {
+    MemoryPool::instance().deallocate(_data, _totalLen + 1);
   }
   _data = nullptr;
 }
 
+boost::string_view MsgNode::view() const {
+  return boost::string_view(_data, _curLen);
+}
+
 void MsgNode::clear() {
   std::memset(_data, 0, _totalLen);
   _curLen = 0;
 }
 
-RecvNode::RecvNode(short len, short msgID) : MsgNode(len), _msgID(msgID) {}
+RecvNode::RecvNode(std::uint32_t len, short msgID)
+    : MsgNode(len), _msgID(msgID), _streamEvent(STREAM_NONE), _streamLen(0) {}
+
+RecvNode::RecvNode(std::shared_ptr<char> chunk, char *data,
+                   std::uint32_t len, short msgID, STREAM_EVENT event,
+                   std::uint32_t streamLen)
+    : MsgNode(std::move(chunk), data, len), _msgID(msgID),
+      _streamEvent(event), _streamLen(streamLen) {}
 
 short RecvNode::getMsgID() const { return _msgID; }
 
-SendNode::SendNode(const char *msg, short len, short msgID)
-    : MsgNode(len + HEAD_TOTAL_LEN), _msgID(msgID) {
-  // 先发id
-  short msgIDHost =
-      boost::asio::detail::socket_ops::host_to_network_short(_msgID);
-  memcpy(_data, &msgIDHost, HEAD_ID_LEN);
-  // 再发长度
-  short lenHost = boost::asio::detail::socket_ops::host_to_network_short(len);
-  memcpy(_data + HEAD_ID_LEN, &lenHost, HEAD_DATA_LEN);
-  // 发送消息体
-  memcpy(_data + HEAD_TOTAL_LEN, msg, len);
+STREAM_EVENT RecvNode::getStreamEvent() const { return _streamEvent; }
+
+std::uint32_t RecvNode::getStreamLen() const { return _streamLen; }
+
+SendNode::SendNode(const char *msg, std::uint32_t len, short msgID,
+                   HEAD_MODE mode)
+    : MsgNode(len + headLen(mode, msgID, len)), _msgID(msgID) {
+  // 先写头部（id + 长度），再拷贝消息体
+  std::size_t head = encodeHead(_data, mode, _msgID, len);
+  memcpy(_data + head, msg, len);
 }
 
-short SendNode::getMsgID() const { return _msgID; }
\ No newline at end of file
+SendNode::SendNode(std::shared_ptr<MsgNode> body, short msgID, HEAD_MODE mode)
+    : MsgNode(headLen(mode, msgID, body->_curLen)), _msgID(msgID),
+      _body(std::move(body)) {
+  encodeHead(_data, mode, _msgID, _body->_curLen);
+}
+
+short SendNode::getMsgID() const { return _msgID; }
+
+std::size_t SendNode::frameLen() const {
+  return _totalLen + (_body ? _body->_curLen : 0);
+}
+
+void SendNode::appendBuffers(
+    std::vector<boost::asio::const_buffer> &buffers) const {
+  buffers.push_back(boost::asio::buffer(_data, _totalLen));
+  if (_body) {
+    buffers.push_back(boost::asio::buffer(_body->_data, _body->_curLen));
+  }
+}
\ No newline at end of file
@@ -1,36 +1,76 @@
 #pragma once
+#include "const.h"
+#include <boost/asio/buffer.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 class CSession;
 class LogicSystem;
 
 class MsgNode {
   friend class CSession;
   friend class LogicSystem;
+  friend class SendNode;
 
 public:
-  MsgNode(short len);
+  MsgNode(std::uint32_t len);
+  // 切片节点：_data 指向共享接收块 chunk 内部，不分配也不拷贝
+  MsgNode(std::shared_ptr<char> chunk, char *data, std::uint32_t len);
   ~MsgNode();
   void clear();
+  // 已接收数据的只读视图，有效期与节点相同
+  boost::string_view view() const;
 
 protected:
-  short _curLen;
-  short _totalLen;
+  std::uint32_t _curLen;
+  std::uint32_t _totalLen;
   char *_data;
+  // 非空时 _data 属于该接收块，节点只持有引用
+  std::shared_ptr<char> _chunk;
+};
+
+// 流式消息的事件，普通消息为 STREAM_NONE
+enum STREAM_EVENT {
+  STREAM_NONE,
+  STREAM_BEGIN, // 消息头已到达，消息体为空，getStreamLen() 为消息体总长
+  STREAM_CHUNK, // 一段消息体
+  STREAM_END,   // 消息体已全部到达
+  STREAM_ABORT, // 连接在消息中途断开
 };
 
 class RecvNode : public MsgNode {
 public:
-  RecvNode(short len, short msgID = 1001);
+  RecvNode(std::uint32_t len, short msgID = 1001);
+  RecvNode(std::shared_ptr<char> chunk, char *data, std::uint32_t len,
+           short msgID, STREAM_EVENT event = STREAM_NONE,
+           std::uint32_t streamLen = 0);
   short getMsgID() const;
+  STREAM_EVENT getStreamEvent() const;
+  std::uint32_t getStreamLen() const;
 
 private:
   short _msgID;
+  STREAM_EVENT _streamEvent;
+  std::uint32_t _streamLen;
 };
 
 class SendNode : public MsgNode {
 public:
-  SendNode(const char *msg, short len, short msgID);
+  // mode 为会话当前协商的消息头格式
+  SendNode(const char *msg, std::uint32_t len, short msgID,
+           HEAD_MODE mode = HEAD_FIXED);
+  // 消息体直接引用 body 的数据（如回显收到的消息），节点里只放头部
+  SendNode(std::shared_ptr<MsgNode> body, short msgID,
+           HEAD_MODE mode = HEAD_FIXED);
   short getMsgID() const;
+  // 整帧字节数，包含头部
+  std::size_t frameLen() const;
+  // 追加本帧的发送缓冲区：头部和消息体连续时一个，引用外部消息体时两个
+  void appendBuffers(std::vector<boost::asio::const_buffer> &buffers) const;
 
 private:
   short _msgID;
-};
\ No newline at end of file
+  std::shared_ptr<MsgNode> _body;
+};
@@ -0,0 +1,206 @@
+#include "RecvBuffer.h"
+#include "MemoryPool.h"
+#include "MsgHead.h"
+#include <algorithm>
+#include <cstring>
+
+RecvBuffer::RecvBuffer(std::size_t chunkSize)
+    : _chunkSize(std::min<std::size_t>(
+          std::max<std::size_t>(chunkSize, RECV_CHUNK_MIN_SIZE),
+          RECV_CHUNK_MAX_SIZE)),
+      _prepared(0), _smallReads(0), _capacity(0), _readPos(0), _writePos(0),
+      _needed(0), _headMode(HEAD_FIXED), _negotiable(true), _inStream(false),
+      _streamMsgID(0), _streamRemain(0), _lastMsgID(0), _lastDataLen(0) {}
+
+boost::asio::mutable_buffer RecvBuffer::prepare() {
+  if (_writePos == _capacity || _capacity - _readPos < _needed) {
+    rebase(std::max<std::size_t>(_needed, HEAD_TOTAL_LEN));
+  }
+  _prepared = _capacity - _writePos;
+  return boost::asio::buffer(_chunk.get() + _writePos, _prepared);
+}
+
+void RecvBuffer::commit(std::size_t len) {
+  _writePos += len;
+  adjustChunkSize(len);
+}
+
+void RecvBuffer::adjustChunkSize(std::size_t len) {
+  // 交出的区域不小于半块且被读满，说明对端发送很快，下一块翻倍
+  if (len == _prepared && len >= _chunkSize / 2) {
+    _chunkSize = std::min<std::size_t>(_chunkSize * 2, RECV_CHUNK_MAX_SIZE);
+    _smallReads = 0;
+    return;
+  }
+  // 连续多次读到的数据很少，逐步缩回，避免偶发的小包就让块来回变化
+  if (len < _chunkSize / 4) {
+    if (++_smallReads >= RECV_SHRINK_READS) {
+      _chunkSize = std::max<std::size_t>(_chunkSize / 2, RECV_CHUNK_MIN_SIZE);
+      _smallReads = 0;
+    }
+    return;
+  }
+  _smallReads = 0;
+}
+
+std::size_t RecvBuffer::chunkSize() const { return _chunkSize; }
+
+bool RecvBuffer::empty() const { return _readPos == _writePos; }
+
+void RecvBuffer::release() {
+  _chunk.reset();
+  _capacity = _readPos = _writePos = 0;
+}
+
+void RecvBuffer::reset() {
+  release();
+  _chunkSize = std::min<std::size_t>(
+      std::max<std::size_t>(RECV_CHUNK_SIZE, RECV_CHUNK_MIN_SIZE),
+      RECV_CHUNK_MAX_SIZE);
+  _prepared = 0;
+  _smallReads = 0;
+  _needed = 0;
+  _headMode = HEAD_FIXED;
+  _negotiable = true;
+  _inStream = false;
+  _streamMsgID = 0;
+  _streamRemain = 0;
+  _lastMsgID = 0;
+  _lastDataLen = 0;
+}
+
+void RecvBuffer::rebase(std::size_t need) {
+  std::size_t pending = _writePos - _readPos;
+  std::size_t capacity = std::max(_chunkSize, need);
+  // 没有切片引用旧数据且大小符合当前目标（或是仍放得下大帧的大块）时原地复用，
+  // 否则换块，接收块的扩大和缩小都在换块时完成
+  if (_chunk && _chunk.use_count() == 1 && need <= _capacity &&
+      (_capacity == capacity || need > _chunkSize)) {
+    // 把剩余的半帧搬到块首即可复用
+    if (pending > 0 && _readPos > 0) {
+      std::memmove(_chunk.get(), _chunk.get() + _readPos, pending);
+    }
+  } else {
+    // 旧块仍被逻辑层的切片引用或大小不合适，换一块新的，旧块随切片释放
+    std::shared_ptr<char> chunk = makePoolBuffer(capacity);
+    if (pending > 0) {
+      std::memcpy(chunk.get(), _chunk.get() + _readPos, pending);
+    }
+    _chunk = std::move(chunk);
+    _capacity = capacity;
+  }
+  _readPos = 0;
+  _writePos = pending;
+}
+
+RecvBuffer::ParseResult RecvBuffer::nextFrame(std::shared_ptr<RecvNode> &node) {
+  if (_inStream) {
+    return nextStreamEvent(node);
+  }
+  std::size_t readable = _writePos - _readPos;
+  if (readable == 0) {
+    _needed = _headMode == HEAD_FIXED ? HEAD_TOTAL_LEN : 1;
+    // 缓冲区已全部消费且无人引用时回到块首，避免无谓的换块
+    if (_chunk && _chunk.use_count() == 1) {
+      _readPos = _writePos = 0;
+    }
+    return PARSE_NEED_MORE;
+  }
+  const char *head = _chunk.get() + _readPos;
+  // 解析消息id和消息体长度，变长头不足时至少再要一个字节
+  short msgID = 0;
+  std::uint32_t dataLen = 0;
+  int headLen = decodeHead(head, readable, _headMode, msgID, dataLen);
+  if (headLen == 0) {
+    _needed = _headMode == HEAD_FIXED ? HEAD_TOTAL_LEN : readable + 1;
+    return PARSE_NEED_MORE;
+  }
+  if (headLen < 0) {
+    return PARSE_ERROR;
+  }
+  _lastMsgID = msgID;
+  _lastDataLen = dataLen;
+  // 判断id和长度是否合法，防止非法数据导致缓冲区溢出
+  if (msgID < 0 || msgID >= MAX_MSG_ID ||
+      dataLen > maxBodyLength(_headMode, msgID)) {
+    return PARSE_ERROR;
+  }
+  if (_streamFilter && _streamFilter(msgID)) {
+    // 流式消息只消费头部，消息体随后按切片交出
+    _readPos += headLen;
+    _needed = 0;
+    _negotiable = false;
+    _inStream = true;
+    _streamMsgID = msgID;
+    _streamRemain = dataLen;
+    node = makePoolShared<RecvNode>(nullptr, nullptr, 0, msgID, STREAM_BEGIN,
+                                    dataLen);
+    return PARSE_FRAME;
+  }
+  std::size_t frameLen = headLen + static_cast<std::size_t>(dataLen);
+  if (readable < frameLen) {
+    _needed = frameLen;
+    return PARSE_NEED_MORE;
+  }
+  _readPos += frameLen;
+  _needed = 0;
+  if (msgID == MSG_NEGOTIATE) {
+    // 只能作为第一条消息，消息体为 1 字节的目标格式，不认识的格式退回定长头
+    if (!_negotiable || dataLen != 1) {
+      return PARSE_ERROR;
+    }
+    _negotiable = false;
+    _headMode = head[headLen] == HEAD_VARINT ? HEAD_VARINT : HEAD_FIXED;
+    return PARSE_NEGOTIATE;
+  }
+  _negotiable = false;
+  node = makePoolShared<RecvNode>(_chunk, _chunk.get() + _readPos - dataLen,
+                                  dataLen, msgID);
+  return PARSE_FRAME;
+}
+
+RecvBuffer::ParseResult
+RecvBuffer::nextStreamEvent(std::shared_ptr<RecvNode> &node) {
+  if (_streamRemain == 0) {
+    _inStream = false;
+    node = makePoolShared<RecvNode>(nullptr, nullptr, 0, _streamMsgID,
+                                    STREAM_END);
+    return PARSE_FRAME;
+  }
+  std::size_t readable = _writePos - _readPos;
+  if (readable == 0) {
+    _needed = 1;
+    if (_chunk && _chunk.use_count() == 1) {
+      _readPos = _writePos = 0;
+    }
+    return PARSE_NEED_MORE;
+  }
+  // 本次读到的消息体整段交出，切片引用接收块，块被占用时下次读取换新块
+  std::uint32_t len = static_cast<std::uint32_t>(
+      std::min<std::size_t>(readable, _streamRemain));
+  node = makePoolShared<RecvNode>(_chunk, _chunk.get() + _readPos, len,
+                                  _streamMsgID, STREAM_CHUNK);
+  _readPos += len;
+  _streamRemain -= len;
+  _needed = 0;
+  return PARSE_FRAME;
+}
+
+void RecvBuffer::setStreamFilter(StreamFilter filter) {
+  _streamFilter = std::move(filter);
+}
+
+std::shared_ptr<RecvNode> RecvBuffer::abortStream() {
+  if (!_inStream) {
+    return nullptr;
+  }
+  _inStream = false;
+  return makePoolShared<RecvNode>(nullptr, nullptr, 0, _streamMsgID,
+                                  STREAM_ABORT);
+}
+
+short RecvBuffer::lastMsgID() const { return _lastMsgID; }
+
+std::uint32_t RecvBuffer::lastDataLen() const { return _lastDataLen; }
+
+HEAD_MODE RecvBuffer::headMode() const { return _headMode; }
@@ -0,0 +1,82 @@
+#pragma once
+#include "MsgNode.h"
+#include "const.h"
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// 会话接收缓冲区：socket 数据直接读入引用计数的接收块，在块内原地解析帧，
+// 完整的消息体以切片 RecvNode 的形式交给逻辑层，不再逐条拷贝和清零。
+// 只有跨越块尾的半帧才会被搬到新块的开头。
+// 消息头默认为定长头，连接上的第一条消息可以是 MSG_NEGOTIATE，
+// 在此直接切换后续数据的消息头格式，不交给逻辑层。
+// 注册为流式的消息 id 不等整条消息到齐：头部到达即产生 STREAM_BEGIN 节点，
+// 之后每次读到的消息体切片产生一个 STREAM_CHUNK 节点，最后是 STREAM_END，
+// 大消息因此不会整条驻留在接收块中。
+// 接收块大小随流量自适应，新块从内存池按当前大小分配。
+class RecvBuffer {
+public:
+  enum ParseResult {
+    PARSE_NEED_MORE, // 数据不足一帧，需要继续读取
+    PARSE_FRAME,     // 解析出一条完整消息
+    PARSE_ERROR,     // 头部非法，应关闭连接
+    PARSE_NEGOTIATE, // 收到协商消息，已切换为 headMode()，需回复应答
+  };
+
+  // 判断消息 id 是否按流式解析
+  using StreamFilter = std::function<bool(short msgID)>;
+
+  explicit RecvBuffer(std::size_t chunkSize = RECV_CHUNK_SIZE);
+
+  // 返回可供 async_read_some 写入的区域
+  boost::asio::mutable_buffer prepare();
+  // 读取完成后提交写入的字节数，并据此调整后续接收块的大小
+  void commit(std::size_t len);
+  // 当前接收块的目标大小
+  std::size_t chunkSize() const;
+  // 没有未解析的数据（可以有未结束的流式消息，它的消息体不在缓冲区中）
+  bool empty() const;
+  // 缓冲区为空时放弃接收块，下次 prepare 再从内存池取；
+  // 块仍被切片引用时随最后一个切片释放
+  void release();
+  // 复位为新建时的状态，保留流式过滤器，会话回收复用时调用
+  void reset();
+  // 解析下一条消息，成功时 node 为引用接收块的切片，流式消息为一个事件
+  ParseResult nextFrame(std::shared_ptr<RecvNode> &node);
+  void setStreamFilter(StreamFilter filter);
+  // 连接断开时若流式消息尚未结束，返回 STREAM_ABORT 节点，否则返回空
+  std::shared_ptr<RecvNode> abortStream();
+  // 最近一次解析出的头部，供出错时打印
+  short lastMsgID() const;
+  std::uint32_t lastDataLen() const;
+  // 当前解析使用的消息头格式
+  HEAD_MODE headMode() const;
+
+private:
+  // 保证从 _readPos 开始至少能容纳 need 字节
+  void rebase(std::size_t need);
+  ParseResult nextStreamEvent(std::shared_ptr<RecvNode> &node);
+  void adjustChunkSize(std::size_t len);
+
+  std::size_t _chunkSize;
+  // 最近一次 prepare 交出的可写字节数，以及连续小读取的次数
+  std::size_t _prepared;
+  std::size_t _smallReads;
+  std::shared_ptr<char> _chunk;
+  std::size_t _capacity;
+  std::size_t _readPos;
+  std::size_t _writePos;
+  // 当前半帧完整需要的字节数，为 0 表示没有要求
+  std::size_t _needed;
+  HEAD_MODE _headMode;
+  // 尚未解析出任何消息，此时才允许协商
+  bool _negotiable;
+  StreamFilter _streamFilter;
+  // 正在接收的流式消息，_streamRemain 为尚未到达的消息体字节数
+  bool _inStream;
+  short _streamMsgID;
+  std::uint32_t _streamRemain;
+  short _lastMsgID;
+  std::uint32_t _lastDataLen;
+};
@@ -0,0 +1,87 @@
+#include "Runtime.h"
+#include "LogicSystem.h"
+
+Runtime::Runtime(std::size_t coreNum, LOGIC_MODE mode)
+    : _pool(coreNum), _logic(new LogicSystem(mode, _pool.size())) {
+  for (std::size_t i = 0; i < _pool.size(); ++i) {
+    std::unique_ptr<Core> core(new Core);
+    core->scheduled = false;
+    core->delivered = 0;
+    core->wakeups = 0;
+    for (std::size_t j = 0; j < _pool.size(); ++j) {
+      core->inbox.emplace_back(new SpscQueue<Task>);
+    }
+    _cores.push_back(std::move(core));
+  }
+}
+
+Runtime::~Runtime() {
+  // 先停 io 线程再停逻辑线程：逻辑线程退出前仍可能向会话投递发送，
+  // 此时只是 post 到已停止的 io_context，不会再访问邮箱。
+  // 逻辑线程处理完的消息节点析构时经 getLogicSystem 记账，
+  // 必须在 reset 把指针置空之前等它们全部退出
+  stop();
+  _logic->stop();
+  _logic.reset();
+}
+
+IOServicePool &Runtime::getIOServicePool() { return _pool; }
+
+LogicSystem &Runtime::getLogicSystem() { return *_logic; }
+
+std::size_t Runtime::coreNum() const { return _pool.size(); }
+
+void Runtime::postTo(std::size_t core, Task task) {
+  std::size_t from = IOServicePool::currentIndex();
+  if (from == IOServicePool::npos || from == core) {
+    boost::asio::post(_pool.getIOService(core), std::move(task));
+    return;
+  }
+  Core &target = *_cores[core];
+  target.inbox[from]->push(std::move(task));
+  // 只有把标志从 false 改为 true 的一方负责唤醒目标核心，
+  // 目标核心处理邮箱期间到达的任务不再逐个 post
+  if (!target.scheduled.exchange(true, std::memory_order_acq_rel)) {
+    boost::asio::post(_pool.getIOService(core),
+                      [this, core]() { drainMailbox(core); });
+  }
+}
+
+void Runtime::drainMailbox(std::size_t core) {
+  Core &self = *_cores[core];
+  // 先清标志再取任务：之后入队的任务要么在本轮取到，要么由生产者重新唤醒
+  self.scheduled.exchange(false, std::memory_order_acq_rel);
+  ++self.wakeups;
+  bool remaining = false;
+  Task task;
+  for (auto &box : self.inbox) {
+    for (int i = 0; i < RUNTIME_MAILBOX_BATCH && box->pop(task); ++i) {
+      task();
+      ++self.delivered;
+    }
+    remaining = remaining || !box->empty();
+  }
+  // 每轮处理有上限，持续投递的核心不会饿死本核心上的读写，剩余的下一轮再处理
+  if (remaining && !self.scheduled.exchange(true, std::memory_order_acq_rel)) {
+    boost::asio::post(_pool.getIOService(core),
+                      [this, core]() { drainMailbox(core); });
+  }
+}
+
+void Runtime::stop() { _pool.stop(); }
+
+std::uint64_t Runtime::mailDelivered() const {
+  std::uint64_t total = 0;
+  for (auto &core : _cores) {
+    total += core->delivered;
+  }
+  return total;
+}
+
+std::uint64_t Runtime::mailWakeups() const {
+  std::uint64_t total = 0;
+  for (auto &core : _cores) {
+    total += core->wakeups;
+  }
+  return total;
+}
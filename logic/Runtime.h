@@ -0,0 +1,58 @@
+#pragma once
+#include "IOServicePool.h"
+#include "SpscQueue.h"
+#include "const.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class LogicSystem;
+
+// 运行时：io_context 池（每个 io 线程即一个核心）、逻辑层和核心之间的邮箱。
+// 由 main 创建后显式传给 Server 和 CSession，不再通过全局单例访问。
+// 核心之间按 (来源, 目标) 各有一个 SPSC 邮箱，目标核心被唤醒一次
+// 就处理积压的一批任务，核心之间投递不争同一把锁。
+class Runtime {
+public:
+  using Task = std::function<void()>;
+
+  // coreNum 为 0 时使用 CPU 核心数
+  explicit Runtime(std::size_t coreNum = IO_POOL_SIZE,
+                   LOGIC_MODE mode = LOGIC_RUN_MODE);
+  ~Runtime();
+  Runtime(const Runtime &) = delete;
+  Runtime &operator=(const Runtime &) = delete;
+
+  IOServicePool &getIOServicePool();
+  LogicSystem &getLogicSystem();
+  std::size_t coreNum() const;
+  // 在核心 core 的 io 线程上执行 task。从其他核心调用时经邮箱投递，
+  // 从本核心或非核心线程（逻辑线程等）调用时直接 post 到该 io_context
+  void postTo(std::size_t core, Task task);
+  // 停止并等待所有 io 线程退出，之后投递的任务不再执行
+  void stop();
+  // 经邮箱送达的任务数和邮箱唤醒次数，stop 之后读取
+  std::uint64_t mailDelivered() const;
+  std::uint64_t mailWakeups() const;
+
+private:
+  struct Core {
+    // 下标为来源核心
+    std::vector<std::unique_ptr<SpscQueue<Task>>> inbox;
+    // 是否已投递了处理邮箱的任务且尚未开始处理
+    std::atomic<bool> scheduled;
+    // 只在本核心线程上修改
+    std::uint64_t delivered;
+    std::uint64_t wakeups;
+    // 各核心的标志和计数不共享缓存行
+    char pad[64];
+  };
+
+  void drainMailbox(std::size_t core);
+
+  IOServicePool _pool;
+  std::unique_ptr<LogicSystem> _logic;
+  std::vector<std::unique_ptr<Core>> _cores;
+};
@@ -1,35 +1,148 @@
 #include "Server.h"
-#include <iostream>
+#include "Logger.h"
 
-Server::Server(boost::asio::io_context &ioc, short port)
-    : _ioc(ioc), _acceptor(ioc, tcp::endpoint(tcp::v4(), port)), _port(port)
+#ifdef SO_REUSEPORT
+using ReusePort = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+Server::Acceptor::Acceptor(boost::asio::io_context &ioc, std::size_t core)
+    : acceptor(ioc), core(core)
+{
+}
+
+Server::Server(boost::asio::io_context &ioc, short port, Runtime &runtime, bool acceptorPerIO)
+    : _ioc(ioc), _runtime(runtime), _pool(runtime.getIOServicePool()), _port(port),
+      _sessionPool(std::make_shared<SessionPool>(runtime, this))
+{
+#ifndef SO_REUSEPORT
+    if (acceptorPerIO)
+    {
+        LOG_WARN("SO_REUSEPORT is not supported, fall back to a single acceptor");
+        acceptorPerIO = false;
+    }
+#endif
+    if (acceptorPerIO)
+    {
+        // 每个 io 线程各自 accept，连接留在接入它的 io_context 上
+        for (std::size_t i = 0; i < _pool.size(); ++i)
+        {
+            _acceptors.emplace_back(new Acceptor(_pool.getIOService(i), i));
+        }
+    }
+    else
+    {
+        _acceptors.emplace_back(new Acceptor(_ioc, IOServicePool::npos));
+    }
+    // 全部绑定成功后再开始 accept，中途失败时构造函数抛出异常
+    for (auto &acceptor : _acceptors)
+    {
+        openAcceptor(*acceptor, acceptorPerIO);
+    }
+    LOG_INFO("Server start success, listen on port : %d, acceptors : %zu", _port,
+             _acceptors.size());
+    for (auto &acceptor : _acceptors)
+    {
+        startAccept(*acceptor);
+    }
+}
+
+void Server::clearCSession(SessionID id)
+{
+    _sessions.erase(id);
+}
+
+std::shared_ptr<CSession> Server::getSession(SessionID id) const
 {
-    std::cout << "Server start success, listen on port : " << _port << std::endl;
-    startAccept();
+    return _sessions.find(id);
 }
 
-void Server::clearCSession(std::string uuid)
+void Server::forEachSession(const SessionRegistry::Visitor &visitor) const
 {
-    _sessions.erase(uuid);
+    _sessions.forEach(visitor);
 }
 
-void Server::startAccept()
+const SessionPool &Server::getSessionPool() const
 {
-    auto newCSession = std::make_shared<CSession>(_ioc, this);
-    _acceptor.async_accept(newCSession->getSocket(),
-                           std::bind(&Server::handleAccept, this, newCSession, _1));
+    return *_sessionPool;
 }
 
-void Server::handleAccept(std::shared_ptr<CSession> newCSession, const boost::system::error_code &error)
+void Server::openAcceptor(Acceptor &acceptor, bool reusePort)
+{
+    tcp::endpoint endpoint(tcp::v4(), _port);
+    acceptor.acceptor.open(endpoint.protocol());
+    acceptor.acceptor.set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+    if (reusePort)
+    {
+        acceptor.acceptor.set_option(ReusePort(true));
+    }
+#endif
+    acceptor.acceptor.bind(endpoint);
+    acceptor.acceptor.listen();
+    // drainAccept 依赖非阻塞 accept 在没有积压连接时立即返回
+    acceptor.acceptor.non_blocking(true);
+}
+
+std::size_t Server::targetCore(Acceptor &acceptor)
+{
+    // 单个 acceptor 时轮询选择一个 io_context，会话之后的读写都在该 io_context 的线程上进行
+    return acceptor.core != IOServicePool::npos ? acceptor.core : _pool.nextIndex();
+}
+
+void Server::startAccept(Acceptor &acceptor)
+{
+    // 连接直接接入到目标 io_context 上的 socket，连接到达后才从对象池取会话
+    std::size_t core = targetCore(acceptor);
+    acceptor.acceptor.async_accept(_pool.getIOService(core),
+                                   [this, &acceptor, core](const boost::system::error_code &error,
+                                                           tcp::socket socket)
+                                   { handleAccept(acceptor, core, error, std::move(socket)); });
+}
+
+void Server::handleAccept(Acceptor &acceptor, std::size_t core,
+                          const boost::system::error_code &error, tcp::socket socket)
 {
     if (!error)
     {
-        newCSession->Start();
-        _sessions[newCSession->getUuid()] = newCSession;
+        newSession(std::move(socket), core);
+        drainAccept(acceptor);
+    }
+    else if (error == boost::asio::error::operation_aborted)
+    {
+        return;
     }
     else
     {
-        std::cerr << "accept error: " << error.message() << std::endl;
+        LOG_ERROR_LIMITED("accept error: %s", error.message().c_str());
+    }
+    startAccept(acceptor);
+}
+
+void Server::drainAccept(Acceptor &acceptor)
+{
+    // 连接突发时一次唤醒接入多个连接，省去每个连接一次 epoll 往返
+    for (int i = 1; i < ACCEPT_BATCH; ++i)
+    {
+        boost::system::error_code error;
+        std::size_t core = targetCore(acceptor);
+        tcp::socket socket = acceptor.acceptor.accept(_pool.getIOService(core), error);
+        if (error)
+        {
+            if (error != boost::asio::error::would_block &&
+                error != boost::asio::error::try_again)
+            {
+                LOG_ERROR_LIMITED("accept error: %s", error.message().c_str());
+            }
+            return;
+        }
+        newSession(std::move(socket), core);
     }
-    startAccept();
+}
+
+void Server::newSession(tcp::socket socket, std::size_t core)
+{
+    std::shared_ptr<CSession> newCSession = _sessionPool->acquire(std::move(socket), core);
+    // 会话放在所属 io 线程对应的会话表分片上，关闭时的删除不碰其他线程的分片
+    newCSession->setID(_sessions.insert(newCSession, core));
+    newCSession->Start();
 }
@@ -2,8 +2,13 @@
 
 #include <boost/asio.hpp>
 #include "CSession.h"
+#include "IOServicePool.h"
+#include "Runtime.h"
+#include "SessionPool.h"
+#include "SessionRegistry.h"
 #include <memory.h>
-#include <map>
+#include <memory>
+#include <vector>
 
 
 using boost::asio::ip::tcp;
@@ -13,16 +18,45 @@ class CSession;
 class Server
 {
 public:
-    Server(boost::asio::io_context &ioc, short port);
-    void clearCSession(std::string uuid); 
+    // acceptorPerIO 为 true 时 runtime 的每个 io_context 各监听一次端口（SO_REUSEPORT），
+    // 否则只在 ioc 上监听
+    Server(boost::asio::io_context &ioc, short port, Runtime &runtime,
+           bool acceptorPerIO = ACCEPTOR_PER_IO);
+    // 会话关闭时从会话表中移除，id 已失效时什么也不做
+    void clearCSession(SessionID id);
+    // 按 id 查找会话，会话已关闭时返回空
+    std::shared_ptr<CSession> getSession(SessionID id) const;
+    // 遍历所有会话，用于超时检查等巡检
+    void forEachSession(const SessionRegistry::Visitor &visitor) const;
+    const SessionPool &getSessionPool() const;
 
 private:
-    void startAccept();
-    void handleAccept(std::shared_ptr<CSession> newCSession, const boost::system::error_code &error);
+    struct Acceptor
+    {
+        Acceptor(boost::asio::io_context &ioc, std::size_t core);
+
+        tcp::acceptor acceptor;
+        // 新连接所在的 io 线程下标，为 npos 时从 io_context 池中轮询
+        std::size_t core;
+    };
+
+    void openAcceptor(Acceptor &acceptor, bool reusePort);
+    void startAccept(Acceptor &acceptor);
+    void handleAccept(Acceptor &acceptor, std::size_t core,
+                      const boost::system::error_code &error, tcp::socket socket);
+    // 唤醒后非阻塞地接入积压的连接，最多 ACCEPT_BATCH - 1 个
+    void drainAccept(Acceptor &acceptor);
+    void newSession(tcp::socket socket, std::size_t core);
+    std::size_t targetCore(Acceptor &acceptor);
 
     boost::asio::io_context &_ioc;
-    tcp::acceptor _acceptor;
+    // 会话所在的 io_context 池和逻辑层
+    Runtime &_runtime;
+    IOServicePool &_pool;
+    std::vector<std::unique_ptr<Acceptor>> _acceptors;
     short _port;
-    std::map<std::string, std::shared_ptr<CSession>> _sessions;
- 
-};
\ No newline at end of file
+    // 会话在不同的 io 线程和逻辑线程上增删查，会话表内部分片加锁
+    SessionRegistry _sessions;
+    // 关闭的会话复位后放回对象池，新连接直接取用
+    std::shared_ptr<SessionPool> _sessionPool;
+};
@@ -0,0 +1,69 @@
+#include "SessionPool.h"
+#include "CSession.h"
+#include "MemoryPool.h"
+#include "Runtime.h"
+
+SessionPool::SessionPool(Runtime &runtime, Server *server,
+                         std::size_t maxIdle)
+    : _runtime(runtime), _server(server), _maxIdle(maxIdle), _reuseCount(0),
+      _createCount(0) {}
+
+SessionPool::~SessionPool() {
+  for (CSession *session : _idle) {
+    delete session;
+  }
+}
+
+std::shared_ptr<CSession>
+SessionPool::acquire(boost::asio::ip::tcp::socket socket, std::size_t core) {
+  CSession *session = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_idle.empty()) {
+      session = _idle.back();
+      _idle.pop_back();
+    }
+  }
+  if (session) {
+    ++_reuseCount;
+  } else {
+    session = new CSession(_runtime.getIOServicePool().getIOService(core),
+                           _server, _runtime);
+    ++_createCount;
+  }
+  session->attach(std::move(socket), core);
+  // 控制块也从内存池分配
+  return std::shared_ptr<CSession>(session, Recycler{shared_from_this()},
+                                   PoolAllocator<CSession>());
+}
+
+void SessionPool::Recycler::operator()(CSession *session) const {
+  std::shared_ptr<SessionPool> owner = pool.lock();
+  if (owner) {
+    owner->release(session);
+  } else {
+    delete session;
+  }
+}
+
+void SessionPool::release(CSession *session) {
+  // 已没有任何引用，复位不需要和其他线程同步
+  session->recycle();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_idle.size() < _maxIdle) {
+      _idle.push_back(session);
+      return;
+    }
+  }
+  delete session;
+}
+
+std::size_t SessionPool::idleCount() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _idle.size();
+}
+
+std::uint64_t SessionPool::reuseCount() const { return _reuseCount; }
+
+std::uint64_t SessionPool::createCount() const { return _createCount; }
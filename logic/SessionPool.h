@@ -0,0 +1,52 @@
+#pragma once
+#include "const.h"
+#include <boost/asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class CSession;
+class Runtime;
+class Server;
+
+// 会话对象池：最后一个引用释放时会话复位后放回空闲链表，
+// 新连接接入后直接取出复用，省去构造和析构 CSession（发送队列哨兵、
+// 回调、接收缓冲区等）的开销，重连风暴时尤其明显。
+// 对象池必须用 make_shared 创建。会话的删除器只持有对象池的 weak_ptr：
+// 空闲会话的控制块要等会话再次被取出才释放，删除器若持有 shared_ptr，
+// 对象池和空闲会话会互相引用而永不析构。对象池析构后才释放的会话直接删除。
+class SessionPool : public std::enable_shared_from_this<SessionPool> {
+public:
+  SessionPool(Runtime &runtime, Server *server,
+              std::size_t maxIdle = SESSION_POOL_MAX_IDLE);
+  ~SessionPool();
+  SessionPool(const SessionPool &) = delete;
+  SessionPool &operator=(const SessionPool &) = delete;
+
+  // 取一个会话并接管已接入 runtime 第 core 个 io_context 的 socket
+  std::shared_ptr<CSession> acquire(boost::asio::ip::tcp::socket socket,
+                                    std::size_t core);
+  std::size_t idleCount() const;
+  // 复用的次数和新建的次数
+  std::uint64_t reuseCount() const;
+  std::uint64_t createCount() const;
+
+private:
+  struct Recycler {
+    std::weak_ptr<SessionPool> pool;
+    void operator()(CSession *session) const;
+  };
+
+  void release(CSession *session);
+
+  Runtime &_runtime;
+  Server *_server;
+  std::size_t _maxIdle;
+  mutable std::mutex _mutex;
+  std::vector<CSession *> _idle;
+  std::atomic<std::uint64_t> _reuseCount;
+  std::atomic<std::uint64_t> _createCount;
+};
@@ -0,0 +1,99 @@
+#include "SessionRegistry.h"
+
+namespace {
+
+const std::uint32_t SHARD_MASK = (1u << SESSION_SHARD_BITS) - 1;
+
+SessionID makeID(std::uint32_t generation, std::uint32_t slot) {
+  return (static_cast<SessionID>(generation) << 32) | slot;
+}
+
+} // namespace
+
+SessionRegistry::SessionRegistry() : _nextShard(0), _size(0) {}
+
+SessionID SessionRegistry::insert(std::shared_ptr<CSession> session) {
+  // 轮询分片，让各分片的槽位数大致均衡
+  return insert(std::move(session),
+                _nextShard.fetch_add(1, std::memory_order_relaxed));
+}
+
+SessionID SessionRegistry::insert(std::shared_ptr<CSession> session,
+                                  std::size_t shardHint) {
+  std::uint32_t shardIndex = static_cast<std::uint32_t>(shardHint & SHARD_MASK);
+  Shard &shard = _shards[shardIndex];
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  std::uint32_t local = 0;
+  if (!shard._freeSlots.empty()) {
+    local = shard._freeSlots.back();
+    shard._freeSlots.pop_back();
+  } else {
+    local = static_cast<std::uint32_t>(shard._slots.size());
+    // 代数从 1 开始，保证 id 不为 INVALID_SESSION_ID
+    shard._slots.push_back(Slot{1, nullptr});
+  }
+  Slot &slot = shard._slots[local];
+  slot.session = std::move(session);
+  ++_size;
+  return makeID(slot.generation, (local << SESSION_SHARD_BITS) | shardIndex);
+}
+
+std::shared_ptr<CSession> SessionRegistry::find(SessionID id) const {
+  std::uint32_t generation = static_cast<std::uint32_t>(id >> 32);
+  std::uint32_t slotIndex = static_cast<std::uint32_t>(id);
+  const Shard &shard = _shards[slotIndex & SHARD_MASK];
+  std::uint32_t local = slotIndex >> SESSION_SHARD_BITS;
+  std::lock_guard<std::mutex> lock(shard._mutex);
+  if (local >= shard._slots.size() ||
+      shard._slots[local].generation != generation) {
+    return nullptr;
+  }
+  return shard._slots[local].session;
+}
+
+bool SessionRegistry::erase(SessionID id) {
+  std::uint32_t generation = static_cast<std::uint32_t>(id >> 32);
+  std::uint32_t slotIndex = static_cast<std::uint32_t>(id);
+  Shard &shard = _shards[slotIndex & SHARD_MASK];
+  std::uint32_t local = slotIndex >> SESSION_SHARD_BITS;
+  std::shared_ptr<CSession> session;
+  {
+    std::lock_guard<std::mutex> lock(shard._mutex);
+    if (local >= shard._slots.size()) {
+      return false;
+    }
+    Slot &slot = shard._slots[local];
+    if (slot.generation != generation || !slot.session) {
+      return false;
+    }
+    session.swap(slot.session);
+    // 代数回绕时跳过 0
+    if (++slot.generation == 0) {
+      slot.generation = 1;
+    }
+    shard._freeSlots.push_back(local);
+  }
+  --_size;
+  // 会话在锁外析构
+  return true;
+}
+
+std::size_t SessionRegistry::size() const { return _size; }
+
+void SessionRegistry::forEach(const Visitor &visitor) const {
+  std::vector<std::shared_ptr<CSession>> snapshot;
+  for (const Shard &shard : _shards) {
+    {
+      std::lock_guard<std::mutex> lock(shard._mutex);
+      for (const Slot &slot : shard._slots) {
+        if (slot.session) {
+          snapshot.push_back(slot.session);
+        }
+      }
+    }
+    for (const auto &session : snapshot) {
+      visitor(session);
+    }
+    snapshot.clear();
+  }
+}
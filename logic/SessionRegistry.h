@@ -0,0 +1,57 @@
+#pragma once
+#include "const.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class CSession;
+
+// 会话 id：高 32 位为槽位的代数，低 32 位为槽位编号（低位是分片号）。
+// 槽位释放后代数加一，已关闭会话的旧 id 不会查到复用该槽位的新会话
+using SessionID = std::uint64_t;
+#define INVALID_SESSION_ID 0
+
+// 分片的会话表：插入、查找、删除都只锁一个分片，按下标直接定位槽位，
+// 不同 io 线程和逻辑线程上的操作基本不会争同一把锁
+class SessionRegistry {
+public:
+  using Visitor = std::function<void(const std::shared_ptr<CSession> &)>;
+
+  SessionRegistry();
+  SessionRegistry(const SessionRegistry &) = delete;
+  SessionRegistry &operator=(const SessionRegistry &) = delete;
+
+  SessionID insert(std::shared_ptr<CSession> session);
+  // 放到指定的分片上（超出分片数时取模），如按会话所属的 io 线程，
+  // 使该线程上的增删只碰自己的分片
+  SessionID insert(std::shared_ptr<CSession> session, std::size_t shardHint);
+  // id 已失效时返回空
+  std::shared_ptr<CSession> find(SessionID id) const;
+  // id 已失效时返回 false
+  bool erase(SessionID id);
+  std::size_t size() const;
+  // 逐个分片取快照后在锁外回调，回调中可以查找或删除会话
+  void forEach(const Visitor &visitor) const;
+
+private:
+  struct Slot {
+    std::uint32_t generation;
+    std::shared_ptr<CSession> session;
+  };
+  // 独占缓存行，避免相邻分片的锁互相干扰
+  struct alignas(64) Shard {
+    mutable std::mutex _mutex;
+    std::vector<Slot> _slots;
+    std::vector<std::uint32_t> _freeSlots;
+  };
+
+  static constexpr std::size_t SHARD_NUM = 1 << SESSION_SHARD_BITS;
+  std::array<Shard, SHARD_NUM> _shards;
+  std::atomic<std::size_t> _nextShard;
+  std::atomic<std::size_t> _size;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+// 无锁单生产者单消费者队列（Vyukov 无界 SPSC 算法）。
+// push 只能由唯一的生产者线程调用，pop/empty 只能由唯一的消费者线程调用。
+// 消费者走过的节点留在链表头部，由生产者回收复用，稳定后不再分配内存；
+// 除了一次 release 写和一次 acquire 读之外两端不共享可写的数据。
+template <class T> class SpscQueue {
+  struct Node {
+    Node() : next(nullptr) {}
+    std::atomic<Node *> next;
+    T value;
+  };
+
+public:
+  SpscQueue() {
+    Node *stub = new Node;
+    _tail.store(stub, std::memory_order_relaxed);
+    _head = stub;
+    _first = stub;
+    _tailCopy = stub;
+  }
+
+  ~SpscQueue() {
+    Node *node = _first;
+    while (node != nullptr) {
+      Node *next = node->next.load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  SpscQueue(const SpscQueue &) = delete;
+  SpscQueue &operator=(const SpscQueue &) = delete;
+
+  void push(T value) {
+    Node *node = allocNode();
+    node->value = std::move(value);
+    node->next.store(nullptr, std::memory_order_relaxed);
+    _head->next.store(node, std::memory_order_release);
+    _head = node;
+  }
+
+  bool pop(T &value) {
+    Node *tail = _tail.load(std::memory_order_relaxed);
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+    value = std::move(next->value);
+    // next 成为新的哨兵，清掉其中的值，不让它引用的对象活到节点被复用
+    next->value = T();
+    _tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return _tail.load(std::memory_order_relaxed)
+               ->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  // 优先复用 [_first, _tail) 中已被消费的节点
+  Node *allocNode() {
+    if (_first != _tailCopy) {
+      Node *node = _first;
+      _first = _first->next.load(std::memory_order_relaxed);
+      return node;
+    }
+    _tailCopy = _tail.load(std::memory_order_acquire);
+    if (_first != _tailCopy) {
+      Node *node = _first;
+      _first = _first->next.load(std::memory_order_relaxed);
+      return node;
+    }
+    return new Node;
+  }
+
+  // 消费者独占，生产者只读；和生产者的字段隔开，避免伪共享
+  std::atomic<Node *> _tail;
+  char _pad[64];
+  // 以下只由生产者访问
+  Node *_head;
+  Node *_first;
+  Node *_tailCopy;
+};
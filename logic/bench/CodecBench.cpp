@@ -0,0 +1,94 @@
+// 消息体编解码基准：对比二进制编码、基于字段声明的 JSON 编码，
+// 以及旧版 helloWorldCallBack 中 json::parse + dump 的吞吐和编码后大小
+#include "../MsgDefs.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// 字段更多的典型业务消息
+struct PlayerState {
+  std::int64_t uid = 0;
+  int level = 0;
+  double x = 0, y = 0;
+  bool online = false;
+  std::string name;
+  std::vector<int> items;
+  MSG_FIELDS(MSG_FIELD(uid) MSG_FIELD(level) MSG_FIELD(x) MSG_FIELD(y)
+                 MSG_FIELD(online) MSG_FIELD(name) MSG_FIELD(items))
+};
+
+struct SyncMsg {
+  int id = 0;
+  std::vector<PlayerState> players;
+  MSG_FIELDS(MSG_FIELD(id) MSG_FIELD(players))
+};
+
+static const int ROUNDS = 200000;
+
+template <class Fn> static double perSecond(int rounds, Fn fn) {
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    fn();
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+  return rounds / cost.count();
+}
+
+template <class T> static void run(const char *name, const T &msg, int rounds) {
+  std::string binary;
+  std::string json;
+  encodeBinary(msg, binary);
+  encodeJson(msg, json);
+
+  double binEncode = perSecond(rounds, [&]() {
+    std::string out;
+    encodeBinary(msg, out);
+  });
+  double binDecode = perSecond(rounds, [&]() {
+    T out;
+    decodeBinary(binary, out);
+  });
+  double jsonEncode = perSecond(rounds, [&]() {
+    std::string out;
+    encodeJson(msg, out);
+  });
+  double jsonDecode = perSecond(rounds, [&]() {
+    T out;
+    decodeJson(json, out);
+  });
+  // 旧版回调：parse 后再 dump 一次
+  double rawJson = perSecond(rounds, [&]() {
+    nlohmann::json js = nlohmann::json::parse(json);
+    std::string out = js.dump();
+  });
+
+  std::printf("%s: size binary %zu B, json %zu B\n", name, binary.size(),
+              json.size());
+  std::printf("  binary encode %.0f/s decode %.0f/s\n", binEncode, binDecode);
+  std::printf("  json   encode %.0f/s decode %.0f/s, parse+dump %.0f/s\n",
+              jsonEncode, jsonDecode, rawJson);
+}
+
+int main() {
+  HelloWorldMsg hello;
+  hello.id = MSG_HELLO_WORLD;
+  hello.data = "hello world";
+  run("HelloWorldMsg", hello, ROUNDS);
+
+  SyncMsg sync;
+  sync.id = 2001;
+  for (int i = 0; i < 10; ++i) {
+    PlayerState player;
+    player.uid = 100000000 + i;
+    player.level = i * 3;
+    player.x = i * 1.5;
+    player.y = i * -2.25;
+    player.online = i % 2 == 0;
+    player.name = "player_" + std::to_string(i);
+    player.items = {1001, 1002, 2003, 40004};
+    sync.players.push_back(player);
+  }
+  run("SyncMsg(10 players)", sync, ROUNDS / 10);
+  return 0;
+}
@@ -0,0 +1,76 @@
+// 消息分发微基准：注册 1/50/500 个 id，对比旧的 std::map<short, std::function>
+// + std::bind 成员函数与 DispatchTable 成员函数注册的单次分发耗时
+#include "../DispatchTable.h"
+#include "../const.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::placeholders;
+
+struct Handler {
+  void onMsg(const std::string &session, short msgID, const std::string &data) {
+    sum += msgID + data.size() + session.size();
+  }
+  std::size_t sum = 0;
+};
+
+using OldCallBack =
+    std::function<void(const std::string &, short, const std::string &)>;
+using Table = DispatchTable<const std::string &, short, const std::string &>;
+
+static const int DISPATCHES = 10000000;
+
+int main() {
+  std::string session = "session";
+  std::string data = "payload";
+  for (int registered : {1, 50, 500}) {
+    Handler handler;
+    std::map<short, OldCallBack> oldTable;
+    Table table(MAX_MSG_ID);
+    std::vector<short> ids;
+    for (int i = 0; i < registered; ++i) {
+      short id = static_cast<short>(1001 + i);
+      ids.push_back(id);
+      oldTable[id] = std::bind(&Handler::onMsg, &handler, _1, _2, _3);
+      table.reg<Handler, &Handler::onMsg>(id, &handler);
+    }
+    // 预先生成随机 id 序列，两边分发相同的序列
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> pick(0, registered - 1);
+    std::vector<short> sequence(1 << 16);
+    for (auto &id : sequence) {
+      id = ids[pick(rng)];
+    }
+    std::size_t mask = sequence.size() - 1;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < DISPATCHES; ++i) {
+      short id = sequence[i & mask];
+      auto iter = oldTable.find(id);
+      if (iter != oldTable.end()) {
+        iter->second(session, id, data);
+      }
+    }
+    std::chrono::duration<double, std::nano> oldCost =
+        std::chrono::steady_clock::now() - begin;
+
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < DISPATCHES; ++i) {
+      short id = sequence[i & mask];
+      table.dispatch(id, session, id, data);
+    }
+    std::chrono::duration<double, std::nano> newCost =
+        std::chrono::steady_clock::now() - begin;
+
+    std::printf("%3d ids: map+function %.2f ns, DispatchTable %.2f ns "
+                "(checksum %zu)\n",
+                registered, oldCost.count() / DISPATCHES,
+                newCost.count() / DISPATCHES, handler.sum);
+  }
+  return 0;
+}
@@ -0,0 +1,75 @@
+// 日志单条开销基准：对比热路径上原来的 std::cout << ... << std::endl
+// 与异步日志 LOG_INFO，输出都指向 /dev/null，只统计调用线程上的耗时
+#include "../Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const int MSGS_PER_THREAD = 200000;
+// 每批不超过环形缓冲区容量，批间等待刷盘，避免统计到丢弃的日志
+static const int BURST = 512;
+
+static double runCout(int threads) {
+  std::ofstream devNull("/dev/null");
+  std::streambuf *old = std::cout.rdbuf(devNull.rdbuf());
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([]() {
+      for (int i = 0; i < MSGS_PER_THREAD; ++i) {
+        std::cout << "recv msg id is " << 1001 << " len " << i << std::endl;
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  std::chrono::duration<double, std::nano> cost =
+      std::chrono::steady_clock::now() - begin;
+  std::cout.rdbuf(old);
+  return cost.count() / (static_cast<double>(MSGS_PER_THREAD) * threads);
+}
+
+static double runLogger(int threads) {
+  std::vector<double> costs(threads, 0.0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([t, &costs]() {
+      for (int i = 0; i < MSGS_PER_THREAD; i += BURST) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int j = i; j < i + BURST; ++j) {
+          LOG_INFO("recv msg id is %d len %d", 1001, j);
+        }
+        std::chrono::duration<double, std::nano> cost =
+            std::chrono::steady_clock::now() - begin;
+        costs[t] += cost.count();
+        Logger::instance().flush();
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  double total = 0;
+  for (double cost : costs) {
+    total += cost;
+  }
+  return total / (static_cast<double>(MSGS_PER_THREAD) * threads);
+}
+
+int main() {
+  std::FILE *devNull = std::fopen("/dev/null", "w");
+  Logger::instance().setOutput(devNull);
+  for (int threads : {1, 4}) {
+    double coutCost = runCout(threads);
+    double loggerCost = runLogger(threads);
+    std::printf("%d threads: std::cout %.1f ns/msg, LOG_INFO %.1f ns/msg\n",
+                threads, coutCost, loggerCost);
+  }
+  Logger::instance().stop();
+  std::fclose(devNull);
+  return 0;
+}
@@ -0,0 +1,102 @@
+// 核心之间投递任务的基准：1/4/16 个生产者线程向同一个 io_context 投递任务，
+// 对比每个任务一次 asio::post 和 Runtime 的 SPSC 邮箱（每个来源一个队列，
+// 只在目标空闲时 post 一次唤醒，醒来后成批处理）
+#include "../SpscQueue.h"
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const std::size_t TOTAL_TASKS = 2000000;
+static const int MAILBOX_BATCH = 256;
+
+using Task = std::function<void()>;
+
+// 旧版 CSession：每次 send 都 post 到会话所在的 io_context
+struct PostDelivery {
+  PostDelivery(boost::asio::io_context &ioc, std::size_t) : ioc(ioc) {}
+  void post(std::size_t, Task task) { boost::asio::post(ioc, std::move(task)); }
+  boost::asio::io_context &ioc;
+};
+
+// 与 Runtime::postTo / drainMailbox 相同的做法
+struct MailboxDelivery {
+  MailboxDelivery(boost::asio::io_context &ioc, std::size_t producers)
+      : ioc(ioc), scheduled(false) {
+    for (std::size_t i = 0; i < producers; ++i) {
+      inbox.emplace_back(new SpscQueue<Task>);
+    }
+  }
+  void post(std::size_t from, Task task) {
+    inbox[from]->push(std::move(task));
+    if (!scheduled.exchange(true, std::memory_order_acq_rel)) {
+      boost::asio::post(ioc, [this]() { drain(); });
+    }
+  }
+  void drain() {
+    scheduled.exchange(false, std::memory_order_acq_rel);
+    bool remaining = false;
+    Task task;
+    for (auto &box : inbox) {
+      for (int i = 0; i < MAILBOX_BATCH && box->pop(task); ++i) {
+        task();
+      }
+      remaining = remaining || !box->empty();
+    }
+    if (remaining && !scheduled.exchange(true, std::memory_order_acq_rel)) {
+      boost::asio::post(ioc, [this]() { drain(); });
+    }
+  }
+  boost::asio::io_context &ioc;
+  std::vector<std::unique_ptr<SpscQueue<Task>>> inbox;
+  std::atomic<bool> scheduled;
+};
+
+template <class Delivery> static double run(std::size_t producers) {
+  boost::asio::io_context ioc(1);
+  auto work = boost::asio::make_work_guard(ioc);
+  Delivery delivery(ioc, producers);
+  std::size_t perProducer = TOTAL_TASKS / producers;
+  std::size_t total = perProducer * producers;
+  // 任务捕获一个 shared_ptr，和 CSession 投递 startWrite 时一样
+  auto payload = std::make_shared<std::size_t>(0);
+  std::size_t done = 0;
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p]() {
+      while (!go) {
+      }
+      for (std::size_t i = 0; i < perProducer; ++i) {
+        delivery.post(p, [&done, &work, total, payload]() {
+          if (++done == total) {
+            work.reset();
+          }
+        });
+      }
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  go = true;
+  ioc.run();
+  auto end = std::chrono::steady_clock::now();
+  for (auto &t : threads) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(end - begin).count();
+  return total / seconds / 1e6;
+}
+
+int main() {
+  for (std::size_t producers : {1, 4, 16}) {
+    double post = run<PostDelivery>(producers);
+    double mailbox = run<MailboxDelivery>(producers);
+    std::cout << "producers " << producers << ": asio::post " << post
+              << " Mtasks/s, mailbox " << mailbox << " Mtasks/s" << std::endl;
+  }
+  return 0;
+}
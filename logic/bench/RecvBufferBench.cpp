@@ -0,0 +1,203 @@
+// 接收解析微基准：对比旧的定长数组 + 逐条拷贝解析与 RecvBuffer 原地切片解析，
+// 单线程运行，输出即为每核吞吐（bytes/sec）
+#include "../MsgNode.h"
+#include "../RecvBuffer.h"
+#include "../const.h"
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 旧版 MsgNode：每条消息单独 new 一块数据
+struct LegacyNode {
+  explicit LegacyNode(short len) : _curLen(0), _totalLen(len) {
+    _data = new char[_totalLen + 1];
+    _data[_totalLen] = '\0';
+  }
+  ~LegacyNode() {
+    std::cout << "destruct MsgNode" << std::endl;
+    delete[] _data;
+  }
+  void clear() {
+    std::memset(_data, 0, _totalLen);
+    _curLen = 0;
+  }
+  short _curLen;
+  short _totalLen;
+  char *_data;
+};
+
+// 旧版 CSession::handleRead 的解析逻辑
+class LegacyParser {
+public:
+  LegacyParser()
+      : _isHeadParse(false), _recvMsgHead(std::make_shared<LegacyNode>(HEAD_TOTAL_LEN)) {}
+
+  std::size_t bufferSize() const { return MAX_LENGTH; }
+  char *buffer() { return _data; }
+
+  // 返回解析出的消息数
+  std::size_t onRead(std::size_t bytes_transferred) {
+    std::size_t frames = 0;
+    int copy_len = 0;
+    while (bytes_transferred > 0) {
+      if (!_isHeadParse) {
+        if (bytes_transferred + _recvMsgHead->_curLen < HEAD_TOTAL_LEN) {
+          memcpy(_recvMsgHead->_data + _recvMsgHead->_curLen, _data + copy_len,
+                 bytes_transferred);
+          _recvMsgHead->_curLen += bytes_transferred;
+          memset(_data, 0, MAX_LENGTH);
+          return frames;
+        }
+        int head_remain = HEAD_TOTAL_LEN - _recvMsgHead->_curLen;
+        memcpy(_recvMsgHead->_data + _recvMsgHead->_curLen, _data + copy_len,
+               head_remain);
+        copy_len += head_remain;
+        bytes_transferred -= head_remain;
+        short data_len = 0;
+        memcpy(&data_len, _recvMsgHead->_data + HEAD_ID_LEN, HEAD_DATA_LEN);
+        data_len =
+            boost::asio::detail::socket_ops::network_to_host_short(data_len);
+        _recvMsgNode = std::make_shared<LegacyNode>(data_len);
+        if (bytes_transferred < static_cast<size_t>(data_len)) {
+          memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
+                 bytes_transferred);
+          _recvMsgNode->_curLen += bytes_transferred;
+          memset(_data, 0, MAX_LENGTH);
+          _isHeadParse = true;
+          return frames;
+        }
+        memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
+               data_len);
+        _recvMsgNode->_curLen += data_len;
+        copy_len += data_len;
+        bytes_transferred -= data_len;
+        _recvMsgNode->_data[_recvMsgNode->_totalLen] = '\0';
+        ++frames;
+        _isHeadParse = false;
+        _recvMsgHead->clear();
+      } else {
+        int remain_msg = _recvMsgNode->_totalLen - _recvMsgNode->_curLen;
+        if (bytes_transferred < static_cast<size_t>(remain_msg)) {
+          memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
+                 bytes_transferred);
+          _recvMsgNode->_curLen += bytes_transferred;
+          memset(_data, 0, MAX_LENGTH);
+          return frames;
+        }
+        memcpy(_recvMsgNode->_data + _recvMsgNode->_curLen, _data + copy_len,
+               remain_msg);
+        _recvMsgNode->_curLen += remain_msg;
+        bytes_transferred -= remain_msg;
+        copy_len += remain_msg;
+        _recvMsgNode->_data[_recvMsgNode->_totalLen] = '\0';
+        ++frames;
+        _isHeadParse = false;
+        _recvMsgHead->clear();
+      }
+    }
+    memset(_data, 0, MAX_LENGTH);
+    return frames;
+  }
+
+private:
+  char _data[MAX_LENGTH];
+  bool _isHeadParse;
+  std::shared_ptr<LegacyNode> _recvMsgHead;
+  std::shared_ptr<LegacyNode> _recvMsgNode;
+};
+
+static std::string makeStream(std::size_t frames) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> lenDist(16, 512);
+  std::string stream;
+  for (std::size_t i = 0; i < frames; ++i) {
+    short len = static_cast<short>(lenDist(rng));
+    short id = boost::asio::detail::socket_ops::host_to_network_short(
+        MSG_HELLO_WORLD);
+    short netLen = boost::asio::detail::socket_ops::host_to_network_short(len);
+    stream.append(reinterpret_cast<const char *>(&id), HEAD_ID_LEN);
+    stream.append(reinterpret_cast<const char *>(&netLen), HEAD_DATA_LEN);
+    stream.append(len, 'x');
+  }
+  return stream;
+}
+
+// readSize 模拟每次 async_read_some 最多拿到的字节数
+static double runLegacy(const std::string &stream, std::size_t readSize,
+                        int rounds) {
+  auto begin = std::chrono::steady_clock::now();
+  std::size_t frames = 0;
+  for (int r = 0; r < rounds; ++r) {
+    LegacyParser parser;
+    for (std::size_t pos = 0; pos < stream.size();) {
+      std::size_t n = std::min(
+          {readSize, parser.bufferSize(), stream.size() - pos});
+      memcpy(parser.buffer(), stream.data() + pos, n);
+      frames += parser.onRead(n);
+      pos += n;
+    }
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+  if (frames == 0) {
+    std::cerr << "legacy parser produced no frames" << std::endl;
+  }
+  return stream.size() * static_cast<double>(rounds) / cost.count();
+}
+
+static double runRecvBuffer(const std::string &stream, std::size_t readSize,
+                            int rounds) {
+  auto begin = std::chrono::steady_clock::now();
+  std::size_t frames = 0;
+  for (int r = 0; r < rounds; ++r) {
+    RecvBuffer buffer;
+    std::shared_ptr<RecvNode> node;
+    for (std::size_t pos = 0; pos < stream.size();) {
+      boost::asio::mutable_buffer space = buffer.prepare();
+      std::size_t n = std::min({readSize, space.size(), stream.size() - pos});
+      memcpy(space.data(), stream.data() + pos, n);
+      buffer.commit(n);
+      pos += n;
+      while (buffer.nextFrame(node) == RecvBuffer::PARSE_FRAME) {
+        ++frames;
+      }
+    }
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+  if (frames == 0) {
+    std::cerr << "RecvBuffer produced no frames" << std::endl;
+  }
+  return stream.size() * static_cast<double>(rounds) / cost.count();
+}
+
+int main() {
+  const std::string stream = makeStream(20000);
+  const int rounds = 20;
+  // MsgNode 析构会打印日志，测量期间屏蔽 std::cout
+  std::ostringstream sink;
+  std::streambuf *old = std::cout.rdbuf(sink.rdbuf());
+  struct Case {
+    const char *name;
+    std::size_t readSize;
+  } cases[] = {{"coalesced", 1 << 16}, {"fragmented", 13}};
+  std::vector<std::string> lines;
+  for (const Case &c : cases) {
+    double legacy = runLegacy(stream, c.readSize, rounds);
+    double ring = runRecvBuffer(stream, c.readSize, rounds);
+    sink.str("");
+    std::ostringstream line;
+    line << c.name << ": legacy " << legacy / 1e6 << " MB/s, RecvBuffer "
+         << ring / 1e6 << " MB/s, x" << ring / legacy;
+    lines.push_back(line.str());
+  }
+  std::cout.rdbuf(old);
+  for (const std::string &line : lines) {
+    std::cout << line << std::endl;
+  }
+  return 0;
+}
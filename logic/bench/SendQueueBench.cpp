@@ -0,0 +1,85 @@
+// 发送队列争用基准：1/4/16 个生产者线程同时投递，一个消费者线程取出，
+// 对比旧的 std::mutex + std::queue、LockedQueue（默认）和 MpscQueue
+#include "../LockedQueue.h"
+#include "../MemoryPool.h"
+#include "../MpscQueue.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+static const std::size_t TOTAL_MSGS = 2000000;
+
+// 旧版 CSession：send 加锁入队，handleWrite 加锁出队
+struct MutexQueue {
+  void push(std::shared_ptr<int> node) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push(std::move(node));
+  }
+  bool pop(std::shared_ptr<int> &node) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) {
+      return false;
+    }
+    node = std::move(queue.front());
+    queue.pop();
+    return true;
+  }
+  std::mutex mutex;
+  std::queue<std::shared_ptr<int>> queue;
+};
+
+// 与 CSession::_sendQueue 相同的配置
+using BatchLockedQueue =
+    LockedQueue<std::shared_ptr<int>, PoolAllocator<std::shared_ptr<int>>>;
+using LockFreeQueue =
+    MpscQueue<std::shared_ptr<int>, PoolAllocator<std::shared_ptr<int>>>;
+
+template <class Queue> static double run(std::size_t producers) {
+  Queue queue;
+  std::size_t perProducer = TOTAL_MSGS / producers;
+  std::size_t total = perProducer * producers;
+  auto payload = std::make_shared<int>(0);
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&]() {
+      while (!go) {
+      }
+      for (std::size_t i = 0; i < perProducer; ++i) {
+        queue.push(payload);
+      }
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  go = true;
+  std::size_t consumed = 0;
+  std::shared_ptr<int> node;
+  while (consumed < total) {
+    if (queue.pop(node)) {
+      ++consumed;
+    }
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - begin;
+  for (auto &t : threads) {
+    t.join();
+  }
+  return total / cost.count();
+}
+
+int main() {
+  for (std::size_t producers : {1, 4, 16}) {
+    double mutex = run<MutexQueue>(producers);
+    double locked = run<BatchLockedQueue>(producers);
+    double lockFree = run<LockFreeQueue>(producers);
+    std::cout << producers << " producers: mutex " << mutex / 1e6
+              << " Mmsg/s, locked " << locked / 1e6 << " Mmsg/s, mpsc "
+              << lockFree / 1e6 << " Mmsg/s, mpsc/locked x"
+              << lockFree / locked << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,746 @@
+// 异步压测客户端：大量连接、目标速率（开环/闭环）、消息大小分布、流水线深度，
+// 输出按计划发送时间修正协调遗漏（coordinated omission）后的延迟分位数。
+//
+// 用法示例：
+//   ./LoadClient --conns 2000 --threads 4 --mode open --rate 200000 --size uniform:16:1024 --duration 30
+//   ./LoadClient --conns 100 --mode closed --depth 8 --size exp:256
+//   ./LoadClient --conns 100 --head varint --size fixed:8
+//   ./LoadClient --conns 50 --mode reconnect --duration 10
+//   ./LoadClient --conns 100 --depth 2 --skew 0.05:0.8
+// reconnect 模式模拟重连风暴：每个连接建立后发一条消息、收到回复即断开重连，
+// 输出每秒建立的连接数，延迟为从发起连接到收到回复的时间。
+// --skew RATIO:SHARE 让 RATIO 比例的连接（热点）承担 SHARE 比例的流量：
+// 闭环下按比例放大热点连接的在途深度，开环下按比例分配速率，
+// 另外单独输出非热点连接的延迟，用来观察热点造成的队头阻塞。
+// 连接数较多时需要先调大 ulimit -n。
+#include "../MsgDefs.h"
+#include "../MsgHead.h"
+#include "../const.h"
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boost::asio::ip;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::string host = "127.0.0.1";
+  unsigned short port = 8888;
+  int conns = 100;
+  int threads = 1;
+  // 总目标速率（条/秒），0 表示闭环下不限速
+  double rate = 0;
+  // open：按计划时间发送，不等回复；closed：最多 depth 条在途
+  bool openLoop = false;
+  // reconnect：每个连接只收发一条消息后断开重连，测接入速率
+  bool reconnect = false;
+  int depth = 1;
+  // 消息体中 data 字段的长度分布：fixed:N / uniform:MIN:MAX / exp:MEAN
+  std::string size = "fixed:64";
+  double duration = 10;
+  double warmup = 1;
+  // 消息头格式，varint 时连接建立后先协商
+  HEAD_MODE headMode = HEAD_FIXED;
+  // 热点连接的比例和它们承担的流量比例，0 表示流量均匀
+  double hotRatio = 0;
+  double hotShare = 0;
+};
+
+// 单个连接的负载：闭环时的在途深度，或开环/限速时的速率
+struct ConnProfile {
+  int depth;
+  double rate;
+  bool hot;
+};
+
+// 对数线性桶的延迟直方图（HdrHistogram 的简化版），相对误差约 1.6%
+class LatencyHistogram {
+public:
+  static const int SUB_BUCKET_BITS = 6;
+  static const std::int64_t SUB_BUCKET_HALF = 1 << SUB_BUCKET_BITS;
+  static const int MAX_BUCKETS = 40;
+
+  LatencyHistogram()
+      : _counts((MAX_BUCKETS + 1) * SUB_BUCKET_HALF, 0), _total(0), _max(0) {}
+
+  void record(std::int64_t valueNs) {
+    if (valueNs < 0) {
+      valueNs = 0;
+    }
+    ++_counts[indexOf(valueNs)];
+    ++_total;
+    _max = std::max(_max, valueNs);
+  }
+
+  void merge(const LatencyHistogram &other) {
+    for (std::size_t i = 0; i < _counts.size(); ++i) {
+      _counts[i] += other._counts[i];
+    }
+    _total += other._total;
+    _max = std::max(_max, other._max);
+  }
+
+  std::int64_t percentile(double p) const {
+    if (_total == 0) {
+      return 0;
+    }
+    std::uint64_t target =
+        static_cast<std::uint64_t>(std::ceil(p / 100.0 * _total));
+    target = std::max<std::uint64_t>(target, 1);
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < _counts.size(); ++i) {
+      seen += _counts[i];
+      if (seen >= target) {
+        return std::min(valueOf(i), _max);
+      }
+    }
+    return _max;
+  }
+
+  std::uint64_t total() const { return _total; }
+  std::int64_t max() const { return _max; }
+
+private:
+  static std::size_t indexOf(std::int64_t value) {
+    if (value < 2 * SUB_BUCKET_HALF) {
+      return static_cast<std::size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(static_cast<unsigned long long>(value));
+    int bucket = std::min(msb - SUB_BUCKET_BITS, MAX_BUCKETS - 1);
+    std::int64_t sub = std::min<std::int64_t>(value >> bucket,
+                                              2 * SUB_BUCKET_HALF - 1);
+    return static_cast<std::size_t>((bucket + 1) * SUB_BUCKET_HALF +
+                                    (sub - SUB_BUCKET_HALF));
+  }
+
+  // 桶的上界
+  static std::int64_t valueOf(std::size_t index) {
+    if (index < static_cast<std::size_t>(2 * SUB_BUCKET_HALF)) {
+      return static_cast<std::int64_t>(index);
+    }
+    std::int64_t bucket = static_cast<std::int64_t>(index) / SUB_BUCKET_HALF - 1;
+    std::int64_t sub =
+        static_cast<std::int64_t>(index) % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+    return ((sub + 1) << bucket) - 1;
+  }
+
+  std::vector<std::uint64_t> _counts;
+  std::uint64_t _total;
+  std::int64_t _max;
+};
+
+class SizeDistribution {
+public:
+  SizeDistribution(const std::string &spec, double maxSize)
+      : _kind(FIXED), _a(64), _b(64), _max(maxSize) {
+    if (spec.compare(0, 6, "fixed:") == 0) {
+      _a = _b = std::atof(spec.c_str() + 6);
+    } else if (spec.compare(0, 8, "uniform:") == 0) {
+      _kind = UNIFORM;
+      std::sscanf(spec.c_str() + 8, "%lf:%lf", &_a, &_b);
+    } else if (spec.compare(0, 4, "exp:") == 0) {
+      _kind = EXPONENTIAL;
+      _a = std::atof(spec.c_str() + 4);
+    } else {
+      throw std::invalid_argument("bad --size " + spec);
+    }
+  }
+
+  // 结果限制在单帧可容纳的范围内，留出 JSON 外壳的空间
+  std::size_t sample(std::mt19937 &rng) const {
+    double value = _a;
+    if (_kind == UNIFORM) {
+      value = std::uniform_real_distribution<double>(_a, _b)(rng);
+    } else if (_kind == EXPONENTIAL) {
+      value = std::exponential_distribution<double>(1.0 / _a)(rng);
+    }
+    return static_cast<std::size_t>(
+        std::max(0.0, std::min(value, _max - 64.0)));
+  }
+
+private:
+  enum Kind { FIXED, UNIFORM, EXPONENTIAL } _kind;
+  double _a;
+  double _b;
+  double _max;
+};
+
+// 每个 io 线程一份，只在该线程上访问，无需加锁
+struct WorkerStats {
+  LatencyHistogram histogram;
+  // 非热点连接的延迟，只在 --skew 时记录
+  LatencyHistogram coldHistogram;
+  std::uint64_t hotReceived = 0;
+  std::uint64_t sent = 0;
+  std::uint64_t received = 0;
+  std::uint64_t errors = 0;
+  std::uint64_t connects = 0;
+};
+
+class LoadConnection : public std::enable_shared_from_this<LoadConnection> {
+public:
+  LoadConnection(boost::asio::io_context &ioc, const Options &options,
+                 const ConnProfile &profile, const SizeDistribution &sizes,
+                 WorkerStats &stats, Clock::time_point measureFrom,
+                 Clock::time_point stopAt, unsigned seed)
+      : _socket(ioc), _timer(ioc), _options(options), _profile(profile),
+        _sizes(sizes), _stats(stats), _measureFrom(measureFrom),
+        _stopAt(stopAt), _rng(seed), _writing(false) {
+    if (_profile.rate > 0) {
+      _interval = std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1 / _profile.rate));
+    }
+  }
+
+  void start(const tcp::endpoint &endpoint) {
+    auto self = shared_from_this();
+    _socket.async_connect(endpoint, [self](const boost::system::error_code &ec) {
+      if (ec) {
+        ++self->_stats.errors;
+        return;
+      }
+      self->_socket.set_option(tcp::no_delay(true));
+      self->doRead();
+      if (self->_options.headMode == HEAD_FIXED) {
+        self->begin();
+        return;
+      }
+      // 协商帧本身用定长头，收到应答后才开始压测
+      char mode = static_cast<char>(self->_options.headMode);
+      self->queueFrame(MSG_NEGOTIATE, boost::string_view(&mode, 1));
+    });
+  }
+
+private:
+  void begin() {
+    if (_profile.rate > 0) {
+      // 打散各连接的起始相位，避免所有连接同时发送
+      std::uniform_int_distribution<Clock::rep> phase(0, _interval.count());
+      _nextSend = Clock::now() + Clock::duration(phase(_rng));
+      scheduleTick();
+    } else {
+      for (int i = 0; i < _profile.depth; ++i) {
+        _slots.push_back(Clock::now());
+      }
+      trySend();
+    }
+  }
+
+  void scheduleTick() {
+    if (_nextSend >= _stopAt) {
+      return;
+    }
+    auto self = shared_from_this();
+    _timer.expires_at(_nextSend);
+    _timer.async_wait([self](const boost::system::error_code &ec) {
+      if (ec) {
+        return;
+      }
+      // 定时器迟到时补齐所有已到期的计划发送
+      Clock::time_point now = Clock::now();
+      while (self->_nextSend <= now && self->_nextSend < self->_stopAt) {
+        self->_slots.push_back(self->_nextSend);
+        self->_nextSend += self->_interval;
+      }
+      self->trySend();
+      self->scheduleTick();
+    });
+  }
+
+  void trySend() {
+    while (!_slots.empty()) {
+      if (!_options.openLoop &&
+          static_cast<int>(_inflight.size()) >= _profile.depth) {
+        return;
+      }
+      Clock::time_point intended = _slots.front();
+      _slots.pop_front();
+      if (intended >= _stopAt) {
+        continue;
+      }
+      sendOne(intended);
+    }
+  }
+
+  void sendOne(Clock::time_point intended) {
+    // 按 const.h 中配置的编码格式生成消息体
+    HelloWorldMsg msg;
+    msg.id = MSG_HELLO_WORLD;
+    msg.data.assign(_sizes.sample(_rng), 'x');
+    std::string body;
+    encodeMsg(MSG_HELLO_WORLD, msg, body);
+    _inflight.push_back(intended);
+    ++_stats.sent;
+    queueFrame(MSG_HELLO_WORLD, body);
+  }
+
+  void queueFrame(short msgID, boost::string_view body) {
+    std::string frame(HEAD_VARINT_MAX_LEN + body.size(), '\0');
+    std::size_t head = encodeHead(&frame[0], _sendHeadMode, msgID,
+                                  static_cast<std::uint32_t>(body.size()));
+    std::memcpy(&frame[head], body.data(), body.size());
+    frame.resize(head + body.size());
+    _writeQueue.push_back(std::move(frame));
+    if (!_writing) {
+      doWrite();
+    }
+  }
+
+  void doWrite() {
+    _writing = true;
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        _socket, boost::asio::buffer(_writeQueue.front()),
+        [self](const boost::system::error_code &ec, std::size_t) {
+          if (ec) {
+            self->fail();
+            return;
+          }
+          self->_writeQueue.pop_front();
+          if (self->_writeQueue.empty()) {
+            self->_writing = false;
+          } else {
+            self->doWrite();
+          }
+        });
+  }
+
+  void doRead() {
+    if (_readBuf.size() - _readLen < 4096) {
+      _readBuf.resize(std::max<std::size_t>(_readBuf.size() * 2, 8192));
+    }
+    auto self = shared_from_this();
+    _socket.async_read_some(
+        boost::asio::buffer(&_readBuf[_readLen], _readBuf.size() - _readLen),
+        [self](const boost::system::error_code &ec, std::size_t n) {
+          if (ec) {
+            self->fail();
+            return;
+          }
+          self->_readLen += n;
+          if (self->parseFrames()) {
+            self->doRead();
+          }
+        });
+  }
+
+  // 解析缓冲区中所有完整的回复，头部非法时返回 false
+  bool parseFrames() {
+    std::size_t pos = 0;
+    while (true) {
+      short msgID = 0;
+      std::uint32_t len = 0;
+      int head = decodeHead(&_readBuf[pos], _readLen - pos, _recvHeadMode,
+                            msgID, len);
+      if (head < 0) {
+        fail();
+        return false;
+      }
+      std::size_t frameLen = static_cast<std::size_t>(head) + len;
+      if (head == 0 || _readLen - pos < frameLen) {
+        break;
+      }
+      pos += frameLen;
+      if (msgID == MSG_NEGOTIATE) {
+        // 服务端不支持时应答为定长头，此时保持原格式
+        _recvHeadMode = _sendHeadMode =
+            len == 1 && _readBuf[pos - 1] == HEAD_VARINT ? HEAD_VARINT
+                                                           : HEAD_FIXED;
+        begin();
+      } else {
+        onReply();
+      }
+    }
+    std::memmove(&_readBuf[0], &_readBuf[pos], _readLen - pos);
+    _readLen -= pos;
+    // 大于缓冲区的帧，扩到能放下整帧
+    short msgID = 0;
+    std::uint32_t len = 0;
+    int head = decodeHead(&_readBuf[0], _readLen, _recvHeadMode, msgID, len);
+    if (head > 0 && static_cast<std::size_t>(head) + len > _readBuf.size()) {
+      _readBuf.resize(static_cast<std::size_t>(head) + len);
+    }
+    return _socket.is_open();
+  }
+
+  void onReply() {
+    Clock::time_point now = Clock::now();
+    ++_stats.received;
+    if (_inflight.empty()) {
+      return;
+    }
+    // 服务端按会话顺序回复，最早的在途请求即为本次回复对应的请求
+    Clock::time_point intended = _inflight.front();
+    _inflight.pop_front();
+    if (intended >= _measureFrom) {
+      std::int64_t ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now - intended)
+              .count();
+      _stats.histogram.record(ns);
+      if (_profile.hot) {
+        ++_stats.hotReceived;
+      } else if (_options.hotRatio > 0) {
+        _stats.coldHistogram.record(ns);
+      }
+    }
+    if (_profile.rate <= 0 && now < _stopAt) {
+      _slots.push_back(now);
+    }
+    trySend();
+    if (now >= _stopAt && _inflight.empty()) {
+      close();
+    }
+  }
+
+  void fail() {
+    if (_socket.is_open()) {
+      ++_stats.errors;
+    }
+    close();
+  }
+
+  void close() {
+    boost::system::error_code ec;
+    _timer.cancel(ec);
+    _socket.close(ec);
+  }
+
+  tcp::socket _socket;
+  boost::asio::steady_timer _timer;
+  const Options &_options;
+  ConnProfile _profile;
+  const SizeDistribution &_sizes;
+  WorkerStats &_stats;
+  Clock::time_point _measureFrom;
+  Clock::time_point _stopAt;
+  std::mt19937 _rng;
+  Clock::duration _interval{0};
+  Clock::time_point _nextSend;
+  // 已到计划时间但尚未发出的请求（闭环在途已满时积压在这里）
+  std::deque<Clock::time_point> _slots;
+  // 已发出等待回复的请求的计划发送时间
+  std::deque<Clock::time_point> _inflight;
+  std::deque<std::string> _writeQueue;
+  bool _writing;
+  // 协商前两个方向都是定长头
+  HEAD_MODE _sendHeadMode = HEAD_FIXED;
+  HEAD_MODE _recvHeadMode = HEAD_FIXED;
+  std::vector<char> _readBuf;
+  std::size_t _readLen = 0;
+};
+
+class ReconnectLoop : public std::enable_shared_from_this<ReconnectLoop> {
+public:
+  ReconnectLoop(boost::asio::io_context &ioc, const Options &options,
+                const SizeDistribution &sizes, WorkerStats &stats,
+                Clock::time_point measureFrom, Clock::time_point stopAt,
+                unsigned seed)
+      : _socket(ioc), _options(options), _sizes(sizes), _stats(stats),
+        _measureFrom(measureFrom), _stopAt(stopAt), _rng(seed) {}
+
+  void start(const tcp::endpoint &endpoint) {
+    _endpoint = endpoint;
+    connect();
+  }
+
+private:
+  void connect() {
+    _begin = Clock::now();
+    if (_begin >= _stopAt) {
+      return;
+    }
+    auto self = shared_from_this();
+    _socket.async_connect(_endpoint, [self](const boost::system::error_code &ec) {
+      if (ec) {
+        self->fail();
+        return;
+      }
+      self->_socket.set_option(tcp::no_delay(true));
+      self->sendHello();
+    });
+  }
+
+  void sendHello() {
+    HelloWorldMsg msg;
+    msg.id = MSG_HELLO_WORLD;
+    msg.data.assign(_sizes.sample(_rng), 'x');
+    std::string body;
+    encodeMsg(MSG_HELLO_WORLD, msg, body);
+    _frame.assign(HEAD_TOTAL_LEN + body.size(), '\0');
+    encodeHead(&_frame[0], HEAD_FIXED, MSG_HELLO_WORLD,
+               static_cast<std::uint32_t>(body.size()));
+    std::memcpy(&_frame[HEAD_TOTAL_LEN], body.data(), body.size());
+    ++_stats.sent;
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        _socket, boost::asio::buffer(_frame),
+        [self](const boost::system::error_code &ec, std::size_t) {
+          if (ec) {
+            self->fail();
+            return;
+          }
+          self->readReply();
+        });
+  }
+
+  void readReply() {
+    auto self = shared_from_this();
+    boost::asio::async_read(
+        _socket, boost::asio::buffer(_head, HEAD_TOTAL_LEN),
+        [self](const boost::system::error_code &ec, std::size_t) {
+          if (ec) {
+            self->fail();
+            return;
+          }
+          short msgID = 0;
+          std::uint32_t len = 0;
+          decodeHead(self->_head, HEAD_TOTAL_LEN, HEAD_FIXED, msgID, len);
+          self->_body.resize(len);
+          boost::asio::async_read(
+              self->_socket, boost::asio::buffer(self->_body),
+              [self](const boost::system::error_code &ec, std::size_t) {
+                if (ec) {
+                  self->fail();
+                  return;
+                }
+                self->onReply();
+              });
+        });
+  }
+
+  void onReply() {
+    Clock::time_point now = Clock::now();
+    ++_stats.received;
+    if (_begin >= _measureFrom) {
+      ++_stats.connects;
+      _stats.histogram.record(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(now - _begin)
+              .count());
+    }
+    reset();
+    connect();
+  }
+
+  void fail() {
+    ++_stats.errors;
+    reset();
+    connect();
+  }
+
+  // 以 RST 断开，客户端不留 TIME_WAIT，长时间压测不会耗尽本地端口
+  void reset() {
+    boost::system::error_code ec;
+    _socket.set_option(boost::asio::socket_base::linger(true, 0), ec);
+    _socket.close(ec);
+  }
+
+  tcp::socket _socket;
+  const Options &_options;
+  const SizeDistribution &_sizes;
+  WorkerStats &_stats;
+  Clock::time_point _measureFrom;
+  Clock::time_point _stopAt;
+  std::mt19937 _rng;
+  tcp::endpoint _endpoint;
+  Clock::time_point _begin;
+  std::string _frame;
+  char _head[HEAD_TOTAL_LEN];
+  std::vector<char> _body;
+};
+
+static void usage() {
+  std::cerr
+      << "usage: LoadClient [--host H] [--port P] [--conns N] [--threads T]\n"
+         "                  [--mode open|closed|reconnect] [--rate MSGS_PER_SEC]\n"
+         "                  [--depth D] [--size fixed:N|uniform:A:B|exp:MEAN]\n"
+         "                  [--duration SEC] [--warmup SEC]\n"
+         "                  [--head fixed|varint] [--skew RATIO:SHARE]\n";
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--host") {
+      options.host = value;
+    } else if (arg == "--port") {
+      options.port = static_cast<unsigned short>(std::atoi(value.c_str()));
+    } else if (arg == "--conns") {
+      options.conns = std::max(1, std::atoi(value.c_str()));
+    } else if (arg == "--threads") {
+      options.threads = std::max(1, std::atoi(value.c_str()));
+    } else if (arg == "--mode") {
+      options.openLoop = value == "open";
+      options.reconnect = value == "reconnect";
+    } else if (arg == "--rate") {
+      options.rate = std::atof(value.c_str());
+    } else if (arg == "--depth") {
+      options.depth = std::max(1, std::atoi(value.c_str()));
+    } else if (arg == "--size") {
+      options.size = value;
+    } else if (arg == "--duration") {
+      options.duration = std::atof(value.c_str());
+    } else if (arg == "--warmup") {
+      options.warmup = std::atof(value.c_str());
+    } else if (arg == "--head") {
+      options.headMode = value == "varint" ? HEAD_VARINT : HEAD_FIXED;
+    } else if (arg == "--skew") {
+      if (std::sscanf(value.c_str(), "%lf:%lf", &options.hotRatio,
+                      &options.hotShare) != 2 ||
+          options.hotRatio <= 0 || options.hotRatio >= 1 ||
+          options.hotShare <= 0 || options.hotShare >= 1) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  // 开环必须有目标速率
+  return !(options.openLoop && options.rate <= 0);
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage();
+    return 1;
+  }
+  try {
+    SizeDistribution sizes(options.size,
+                           maxBodyLength(options.headMode, MSG_HELLO_WORLD));
+    tcp::endpoint endpoint(address::from_string(options.host), options.port);
+    Clock::time_point begin = Clock::now();
+    auto toDuration = [](double seconds) {
+      return std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(seconds));
+    };
+    Clock::time_point measureFrom = begin + toDuration(options.warmup);
+    Clock::time_point stopAt = measureFrom + toDuration(options.duration);
+
+    std::vector<std::unique_ptr<boost::asio::io_context>> contexts;
+    std::vector<WorkerStats> stats(options.threads);
+    for (int t = 0; t < options.threads; ++t) {
+      contexts.emplace_back(new boost::asio::io_context(1));
+    }
+    // 热点连接排在前面，按 --skew 计算各连接的在途深度和速率
+    int hotConns = 0;
+    if (options.hotRatio > 0) {
+      hotConns = std::min(
+          options.conns - 1,
+          std::max(1, static_cast<int>(std::lround(options.conns *
+                                                   options.hotRatio))));
+    }
+    auto profileOf = [&options, hotConns](int c) {
+      ConnProfile profile{options.depth, options.rate / options.conns,
+                          c < hotConns};
+      if (hotConns == 0) {
+        return profile;
+      }
+      int coldConns = options.conns - hotConns;
+      double coldShare = (1 - options.hotShare) / coldConns;
+      double share = profile.hot ? options.hotShare / hotConns : coldShare;
+      profile.rate = options.rate * share;
+      if (profile.hot) {
+        // 闭环下各连接的流量近似和在途深度成正比
+        profile.depth = std::max(
+            1, static_cast<int>(std::lround(options.depth * share / coldShare)));
+      }
+      return profile;
+    };
+    for (int c = 0; c < options.conns; ++c) {
+      int t = c % options.threads;
+      if (options.reconnect) {
+        std::make_shared<ReconnectLoop>(*contexts[t], options, sizes, stats[t],
+                                        measureFrom, stopAt, 1000 + c)
+            ->start(endpoint);
+        continue;
+      }
+      std::make_shared<LoadConnection>(*contexts[t], options, profileOf(c),
+                                       sizes, stats[t], measureFrom, stopAt,
+                                       1000 + c)
+          ->start(endpoint);
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; ++t) {
+      boost::asio::io_context &ioc = *contexts[t];
+      threads.emplace_back([&ioc, stopAt]() {
+        // 结束后最多再等 2 秒收完在途回复
+        ioc.run_until(stopAt + std::chrono::seconds(2));
+      });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+
+    WorkerStats total;
+    for (auto &s : stats) {
+      total.histogram.merge(s.histogram);
+      total.coldHistogram.merge(s.coldHistogram);
+      total.hotReceived += s.hotReceived;
+      total.sent += s.sent;
+      total.received += s.received;
+      total.errors += s.errors;
+      total.connects += s.connects;
+    }
+    double us = 1000.0;
+    std::printf("mode %s, conns %d, threads %d, depth %d, size %s, head %s\n",
+                options.reconnect  ? "reconnect"
+                : options.openLoop ? "open"
+                                   : "closed",
+                options.conns,
+                options.threads, options.depth, options.size.c_str(),
+                options.headMode == HEAD_VARINT ? "varint" : "fixed");
+    std::printf("sent %llu, received %llu, errors %llu, measured %llu, "
+                "throughput %.0f msg/s\n",
+                static_cast<unsigned long long>(total.sent),
+                static_cast<unsigned long long>(total.received),
+                static_cast<unsigned long long>(total.errors),
+                static_cast<unsigned long long>(total.histogram.total()),
+                total.histogram.total() / options.duration);
+    if (options.reconnect) {
+      std::printf("connections %llu, accept rate %.0f conn/s\n",
+                  static_cast<unsigned long long>(total.connects),
+                  total.connects / options.duration);
+    }
+    std::printf("latency(us) p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f "
+                "p99.99 %.1f max %.1f\n",
+                total.histogram.percentile(50) / us,
+                total.histogram.percentile(90) / us,
+                total.histogram.percentile(99) / us,
+                total.histogram.percentile(99.9) / us,
+                total.histogram.percentile(99.99) / us,
+                total.histogram.max() / us);
+    if (hotConns > 0) {
+      std::printf("hot conns %d (depth %d) carried %.1f%% of replies\n",
+                  hotConns, profileOf(0).depth,
+                  100.0 * total.hotReceived /
+                      std::max<std::uint64_t>(1, total.histogram.total()));
+      std::printf("cold latency(us) p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f "
+                  "max %.1f\n",
+                  total.coldHistogram.percentile(50) / us,
+                  total.coldHistogram.percentile(90) / us,
+                  total.coldHistogram.percentile(99) / us,
+                  total.coldHistogram.percentile(99.9) / us,
+                  total.coldHistogram.max() / us);
+    }
+  } catch (std::exception &e) {
+    std::cerr << "Exception: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
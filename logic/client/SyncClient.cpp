@@ -2,13 +2,45 @@
 #include <boost/asio.hpp>
 #include <thread>
 #include <nlohmann/json.hpp>
+#include "../MsgDefs.h"
+#include "../MsgHead.h"
 #include "../const.h"
 
 using nlohmann::json;
 using namespace std;
 using namespace boost::asio::ip;
 
-int main()
+//按当前消息头格式读一帧，变长头逐字节读到头部完整为止
+static short read_frame(tcp::socket &sock, HEAD_MODE mode, std::string &body)
+{
+	char head[HEAD_VARINT_MAX_LEN] = { 0 };
+	size_t head_len = mode == HEAD_FIXED ? HEAD_TOTAL_LEN : 1;
+	boost::asio::read(sock, boost::asio::buffer(head, head_len));
+	short msgid = 0;
+	std::uint32_t msglen = 0;
+	int ret = 0;
+	while ((ret = decodeHead(head, head_len, mode, msgid, msglen)) == 0) {
+		boost::asio::read(sock, boost::asio::buffer(head + head_len, 1));
+		++head_len;
+	}
+	if (ret < 0 || msglen > maxBodyLength(mode, msgid)) {
+		throw std::runtime_error("bad reply head");
+	}
+	body.resize(msglen);
+	boost::asio::read(sock, boost::asio::buffer(&body[0], msglen));
+	return msgid;
+}
+
+static void write_frame(tcp::socket &sock, HEAD_MODE mode, short msgid, const std::string &body)
+{
+	std::string frame(HEAD_VARINT_MAX_LEN + body.size(), '\0');
+	size_t head_len = encodeHead(&frame[0], mode, msgid, static_cast<std::uint32_t>(body.size()));
+	memcpy(&frame[head_len], body.data(), body.size());
+	boost::asio::write(sock, boost::asio::buffer(frame.data(), head_len + body.size()));
+}
+
+//用法: SyncClient [varint]，带 varint 参数时先协商变长头
+int main(int argc, char *argv[])
 {
 	try
 	{
@@ -26,45 +58,44 @@ int main()
 			return 0;
 		}
 
-		thread send_thread([&sock]
+		HEAD_MODE head_mode = HEAD_FIXED;
+		if (argc > 1 && std::string(argv[1]) == "varint") {
+			//协商帧和应答都用定长头，应答里是服务端接受的格式
+			write_frame(sock, HEAD_FIXED, MSG_NEGOTIATE, std::string(1, HEAD_VARINT));
+			std::string ack;
+			if (read_frame(sock, HEAD_FIXED, ack) == MSG_NEGOTIATE && ack.size() == 1) {
+				head_mode = static_cast<HEAD_MODE>(ack[0]);
+			}
+			cout << "head mode is " << (head_mode == HEAD_VARINT ? "varint" : "fixed") << endl;
+		}
+
+		thread send_thread([&sock, head_mode]
 						   {
 			for (;;) {
 				this_thread::sleep_for(std::chrono::milliseconds(2000));
-				json js;
-				js["data"]="hello world";
-				//发送id
-				int msgid=1001;
-				int msgid_host=boost::asio::detail::socket_ops::host_to_network_short(msgid);
-				js["id"]=msgid;
-				std::string request=js.dump();
-				short request_length = static_cast<short>(request.size());
-				char send_data[MAX_LENGTH] = { 0 };
-				memcpy(send_data, &msgid_host, 2);
-				//转为网络字节序
-				short request_host_length = boost::asio::detail::socket_ops::host_to_network_short(request_length);
-				memcpy(send_data+2, &request_host_length, 2);
-				memcpy(send_data + 4, request.c_str(), request_length);
-				boost::asio::write(sock, boost::asio::buffer(send_data, request_length + 4));
+				HelloWorldMsg hello;
+				hello.data="hello world";
+				int msgid=MSG_HELLO_WORLD;
+				hello.id=msgid;
+				//按 const.h 中配置的格式编码
+				std::string request;
+				encodeMsg(msgid, hello, request);
+				write_frame(sock, head_mode, msgid, request);
 			} });
 
-		thread recv_thread([&sock]
+		thread recv_thread([&sock, head_mode]
 						   {
 			for (;;) {
 				this_thread::sleep_for(std::chrono::milliseconds(2));
 				cout << "begin to receive..." << endl;
-				char reply_head[HEAD_TOTAL_LEN];
-				boost::asio::read(sock, boost::asio::buffer(reply_head, HEAD_TOTAL_LEN));
-				short msgid=0;
-				memcpy(&msgid, reply_head+2, 2);
-				short msglen = 0;
-				memcpy(&msglen, reply_head+2, 2);
-				//转为本地字节序
-				msgid = boost::asio::detail::socket_ops::network_to_host_short(msgid);
-				msglen = boost::asio::detail::socket_ops::network_to_host_short(msglen);
-				char msg[MAX_LENGTH] = { 0 };
-				size_t msg_lenght=boost::asio::read(sock, boost::asio::buffer(msg, msglen));
-				json js=json::parse(std::string(msg,msg_lenght));
-				std::cout<<"id is "<<js["id"]<<" msg is "<<js["data"]<<std::endl;	
+				std::string msg;
+				short msgid = read_frame(sock, head_mode, msg);
+				HelloWorldMsg reply;
+				if (!decodeMsg(msgid, boost::string_view(msg), reply)) {
+					std::cout<<"bad reply, msg id is "<<msgid<<std::endl;
+					continue;
+				}
+				std::cout<<"id is "<<reply.id<<" msg is "<<reply.data<<std::endl;
 			} });
 
 		send_thread.join();
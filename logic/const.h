@@ -1,11 +1,163 @@
 #pragma once
+#include <cstdint>
 #define HEAD_TOTAL_LEN 4
 #define HEAD_ID_LEN 2
 #define HEAD_DATA_LEN 2
 #define MAX_LENGTH 2048
-#define MAX_QUEUE_SIZE 1000
+// 变长头：id 和长度各为一个 varint，id 最多 3 字节、长度最多 5 字节
+#define HEAD_VARINT_MAX_LEN 8
+// 变长头模式下消息体的默认上限，可在 msgMaxLength 中按消息 id 单独配置，
+// 协议本身支持 32 位长度，调大时注意 SEND_MAX_BYTES
+#define MAX_BODY_LENGTH (1024 * 1024)
+// 流式上传的消息体上限，消息体按分片交给处理器，不会整条驻留内存
+#define MAX_UPLOAD_LENGTH (256 * 1024 * 1024)
+// 每个会话已读入、尚未被流式处理器消费的字节上限，超过后暂停读取
+#define STREAM_WINDOW_BYTES (256 * 1024)
+// 每个会话已交给逻辑层、尚未处理完的消息数上限，超过后暂停读取该会话，
+// 回落到一半以下时恢复，由 TCP 流控把压力传回客户端
+#define LOGIC_SESSION_PENDING_MAX 1024
+// 所有会话合计的上限，超过后各会话读完当前数据即暂停，
+// 回落到 LOGIC_TOTAL_PENDING_LOW 以下时恢复
+#ifndef LOGIC_TOTAL_PENDING_MAX
+#define LOGIC_TOTAL_PENDING_MAX 65536
+#endif
+#define LOGIC_TOTAL_PENDING_LOW (LOGIC_TOTAL_PENDING_MAX / 4 * 3)
+// 消息 id 的取值范围 [0, MAX_MSG_ID)，回调表按 id 直接下标
+#define MAX_MSG_ID 2048
+// 会话发送队列的字节水位：超过高水位通知上层暂停向该会话生产，降到低水位通知恢复
+#define SEND_HIGH_WATERMARK (1024 * 1024)
+#define SEND_LOW_WATERMARK (256 * 1024)
+// 会话发送队列的字节上限，超过后丢弃消息并计数
+#define SEND_MAX_BYTES (4 * 1024 * 1024)
+// 会话发送队列的实现：0 为加锁队列，1 为无锁 MPSC 队列。
+// 单核上 MPSC 每次 push 都要分配节点，实测比加锁队列慢，多核压测确认占优后再开启
+#ifndef SEND_QUEUE_MPSC
+#define SEND_QUEUE_MPSC 0
+#endif
+// 一次聚合写最多带走的字节数和缓冲区个数
+#define SEND_BATCH_MAX_BYTES 65536
+#define SEND_BATCH_MAX_BUFS 64
+// 会话接收块的初始大小和自适应调整范围：读取连续填满接收块时翻倍，
+// 连续 RECV_SHRINK_READS 次读到不足四分之一时减半。
+// 放不下的大帧会临时取更大的块，不受上限约束
+#define RECV_CHUNK_SIZE 4096
+#define RECV_CHUNK_MIN_SIZE 2048
+#define RECV_CHUNK_MAX_SIZE 65536
+#define RECV_SHRINK_READS 8
+// 会话表分片数为 2^SESSION_SHARD_BITS，会话放在所属 io 线程对应的分片上，
+// 64 个以内的 io 线程各自独占一个分片
+#define SESSION_SHARD_BITS 6
+// 会话对象池最多缓存的空闲会话数，超出的直接释放
+#define SESSION_POOL_MAX_IDLE 65536
+// 空闲会话的发送、批量投递等容器最多保留的元素容量，超出的复位时释放
+#define SESSION_POOL_KEEP_CAPACITY 64
+// 为 1 时每个 io_context 各有一个以 SO_REUSEPORT 绑定同一端口的 acceptor，
+// 由内核把新连接分散到各个 io 线程；为 0 时只有一个 acceptor，连接轮询分配
+#ifndef ACCEPTOR_PER_IO
+#define ACCEPTOR_PER_IO 0
+#endif
+// acceptor 每次被唤醒后最多连续接入的连接数，积压的连接不必逐个等待下一次唤醒
+#define ACCEPT_BATCH 32
+// io_context 池大小，0 表示使用 CPU 核心数
+#define IO_POOL_SIZE 0
+// 逻辑线程数，0 表示使用 CPU 核心数；同一会话的消息由同一线程按序处理
+#ifndef LOGIC_WORKER_NUM
+#define LOGIC_WORKER_NUM 0
+#endif
+// 逻辑层运行方式，取值见 LOGIC_MODE
+#ifndef LOGIC_RUN_MODE
+#define LOGIC_RUN_MODE LOGIC_THREADED
+#endif
+// LOGIC_WORK_STEALING 模式下会话每次被调度最多处理的消息数，处理完仍有消息时
+// 排到运行队列末尾，让同一线程上的其他会话先运行
+#define LOGIC_SESSION_BUDGET 32
+// 执行池 "bulk" 的线程数和排队上限，耗时的消息 id（如 MSG_UPLOAD）绑定到该池，
+// 不占用处理短消息的逻辑线程
+#ifndef LOGIC_BULK_POOL_THREADS
+#define LOGIC_BULK_POOL_THREADS 1
+#endif
+#define LOGIC_BULK_POOL_QUEUE_LIMIT 4096
+// 为 1 时标记为非阻塞的消息 id 在 io 线程上直接调用回调，不经过逻辑层的队列，
+// 也不受逻辑层的批量投递、工作窃取和入站积压上限的约束；默认关闭，按需开启
+#ifndef LOGIC_INLINE_HANDLERS
+#define LOGIC_INLINE_HANDLERS 0
+#endif
+// 内联回调看门狗，调试时用 -DLOGIC_INLINE_WATCHDOG=1 开启：
+// 内联回调执行超过 LOGIC_INLINE_WARN_US 微秒时记录日志并计数，
+// 看门狗线程每 LOGIC_INLINE_WATCHDOG_MS 毫秒检查一次仍未返回的内联回调。
+// io 线程被调度出去时也会超时，负载高的机器上可能误报
+#ifndef LOGIC_INLINE_WATCHDOG
+#define LOGIC_INLINE_WATCHDOG 0
+#endif
+#define LOGIC_INLINE_WARN_US 1000
+#define LOGIC_INLINE_WATCHDOG_MS 100
+// 核心之间的邮箱每次唤醒从每个来源最多处理的任务数
+#define RUNTIME_MAILBOX_BATCH 256
 
 enum MSG_IDS{
+    // 协商消息头格式，只能作为连接上的第一条消息，由接收层直接处理
+    MSG_NEGOTIATE=1,
     MSG_HELLO_WORLD=1001,
+    // 流式上传，消息体按分片处理，结束时回复 UploadAckMsg
+    MSG_UPLOAD=1002,
     
-};
\ No newline at end of file
+};
+
+// 逻辑层运行方式
+enum LOGIC_MODE{
+    // 独立的逻辑线程池，会话按地址散列到固定的逻辑线程
+    LOGIC_THREADED=0,
+    // 每个 io 线程即一个核心，会话的消息在所属 io 线程上直接处理，
+    // 每个核心有自己的逻辑分片和会话表分片，处理器中不能有阻塞操作
+    LOGIC_PER_CORE=1,
+    // 逻辑线程池，每个会话有自己的消息邮箱，有消息的会话在各线程的运行队列间
+    // 可被窃取，突发的会话不会长期占住一个线程
+    LOGIC_WORK_STEALING=2,
+};
+
+// 消息体编码格式，JSON 作为调试/兼容模式保留
+enum MSG_CODEC{
+    CODEC_JSON=0,
+    CODEC_BINARY=1,
+};
+
+// 各消息 id 使用的编码格式，客户端和服务端需一致
+#ifndef MSG_HELLO_WORLD_CODEC
+#define MSG_HELLO_WORLD_CODEC CODEC_JSON
+#endif
+
+inline MSG_CODEC msgCodec(short msgID)
+{
+    switch (msgID)
+    {
+    case MSG_HELLO_WORLD:
+        return MSG_HELLO_WORLD_CODEC;
+    default:
+        return CODEC_JSON;
+    }
+}
+
+// 消息头格式，连接建立时为定长头，客户端发送 MSG_NEGOTIATE 切换
+enum HEAD_MODE{
+    HEAD_FIXED=0,
+    HEAD_VARINT=1,
+};
+
+// 变长头模式下各消息 id 允许的消息体长度，定长头模式固定为 MAX_LENGTH
+inline std::uint32_t msgMaxLength(short msgID)
+{
+    switch (msgID)
+    {
+    case MSG_NEGOTIATE:
+        return 1;
+    case MSG_UPLOAD:
+        return MAX_UPLOAD_LENGTH;
+    default:
+        return MAX_BODY_LENGTH;
+    }
+}
+
+inline std::uint32_t maxBodyLength(HEAD_MODE mode, short msgID)
+{
+    return mode == HEAD_FIXED ? MAX_LENGTH : msgMaxLength(msgID);
+}
@@ -1,19 +1,77 @@
 #include"CSession.h"
+#include"Logger.h"
+#include"LogicSystem.h"
+#include"MemoryPool.h"
+#include"Runtime.h"
 #include"Server.h"
-#include<iostream>
 
 int main()
 {
     try
     {
+        // io_context 负责 accept，会话的读写分配到 runtime 中的各个 io_context 上，
+        // 逻辑层也由 runtime 持有，显式传给 Server。
+        // 未完成的 accept 持有目标 io_context 上的 socket，io_context 必须声明在
+        // runtime 之后，先于 io_context 池析构
+        Runtime runtime(IO_POOL_SIZE, LOGIC_RUN_MODE);
         boost::asio::io_context io_context;
-        Server server(io_context, 8888);
+        boost::asio::signal_set signals(io_context, SIGINT, SIGTERM);
+        signals.async_wait([&io_context, &runtime](const boost::system::error_code &, int) {
+            io_context.stop();
+            runtime.stop();
+        });
+        Server server(io_context, 8888, runtime);
         io_context.run();
+        MemoryPool::Stats stats = MemoryPool::instance().stats();
+        LOG_INFO("MemoryPool hit rate %.4f, in use %llu bytes, peak in use %llu bytes, "
+                 "reserved %llu bytes",
+                 stats.hitRate(), static_cast<unsigned long long>(stats.inUseBytes),
+                 static_cast<unsigned long long>(stats.peakInUseBytes),
+                 static_cast<unsigned long long>(stats.reservedBytes));
+        LOG_INFO("send queue dropped %llu msgs",
+                 static_cast<unsigned long long>(CSession::getTotalDropCount()));
+        LOG_INFO("inbound reads paused %llu times, logic pending peak %zu msgs",
+                 static_cast<unsigned long long>(CSession::getTotalReadPauses()),
+                 runtime.getLogicSystem().getPeakPendingMsgs());
+        LOG_INFO("session pool reused %llu, created %llu",
+                 static_cast<unsigned long long>(server.getSessionPool().reuseCount()),
+                 static_cast<unsigned long long>(server.getSessionPool().createCount()));
+        LOG_INFO("runtime mailbox delivered %llu tasks in %llu wakeups",
+                 static_cast<unsigned long long>(runtime.mailDelivered()),
+                 static_cast<unsigned long long>(runtime.mailWakeups()));
+        if (runtime.getLogicSystem().getMode() == LOGIC_WORK_STEALING)
+        {
+            LOG_INFO("logic workers stole sessions %llu times",
+                     static_cast<unsigned long long>(runtime.getLogicSystem().getStealCount()));
+        }
+#if LOGIC_INLINE_WATCHDOG
+        LOG_INFO("inline handlers overran %d us %llu times", LOGIC_INLINE_WARN_US,
+                 static_cast<unsigned long long>(runtime.getLogicSystem().getInlineOverruns()));
+#endif
+        // 执行池排空剩余消息后再读取统计
+        runtime.getLogicSystem().stop();
+        for (const ExecPool::Stats &pool : runtime.getLogicSystem().poolStats())
+        {
+            LOG_INFO("exec pool %s: threads %zu, processed %llu, dropped %llu, peak depth %zu/%zu, "
+                     "wait p50/p99/max %llu/%llu/%llu us, run p50/p99/max %llu/%llu/%llu us",
+                     pool.name.c_str(), pool.threads,
+                     static_cast<unsigned long long>(pool.processed),
+                     static_cast<unsigned long long>(pool.dropped), pool.peakDepth, pool.queueLimit,
+                     static_cast<unsigned long long>(pool.waitP50),
+                     static_cast<unsigned long long>(pool.waitP99),
+                     static_cast<unsigned long long>(pool.waitMax),
+                     static_cast<unsigned long long>(pool.runP50),
+                     static_cast<unsigned long long>(pool.runP99),
+                     static_cast<unsigned long long>(pool.runMax));
+        }
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Exception: " << e.what() << "\n";
+        LOG_ERROR("Exception: %s", e.what());
+        Logger::instance().stop();
         return 1;
     }
+    // 之后单例析构时的日志同步写出
+    Logger::instance().stop();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,67 @@
+// 消息体二进制编解码的截断测试：顶层缺少末尾字段时保持默认值，
+// 嵌套结构体内部被截断时解码失败
+#include "../MsgDefs.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct Inner {
+  int a = 0;
+  std::string b;
+  MSG_FIELDS(MSG_FIELD(a) MSG_FIELD(b))
+};
+
+struct Outer {
+  int id = 0;
+  Inner inner;
+  std::vector<Inner> list;
+  MSG_FIELDS(MSG_FIELD(id) MSG_FIELD(inner) MSG_FIELD(list))
+};
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+  if (!cond) {
+    std::printf("FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+int main() {
+  Outer msg;
+  msg.id = 7;
+  msg.inner.a = 3;
+  msg.inner.b = "nested";
+  msg.list.push_back(msg.inner);
+  std::string full;
+  encodeBinary(msg, full);
+
+  Outer decoded;
+  check(decodeBinary(full, decoded) && decoded.id == 7 &&
+            decoded.inner.b == "nested" && decoded.list.size() == 1,
+        "full message decodes");
+
+  // 只有 id：后面的字段整体缺失，保持默认值
+  std::string idOnly;
+  encodeBinary(Outer{7, Inner(), {}}, idOnly);
+  idOnly.resize(1);
+  Outer head;
+  check(decodeBinary(idOnly, head) && head.id == 7 && head.inner.a == 0,
+        "missing trailing top-level fields keep defaults");
+
+  // id + inner.a，截断在 inner.b 之前
+  Outer cut;
+  check(!decodeBinary(boost::string_view(full.data(), 2), cut),
+        "truncation inside a nested struct fails");
+
+  // 截断在数组元素内部：元素的 a 完整，b（1 字节长度 + 6 字节内容）缺失
+  Outer cutList;
+  check(!decodeBinary(boost::string_view(full.data(), full.size() - 7),
+                      cutList),
+        "truncation inside a nested array element fails");
+
+  if (failures == 0) {
+    std::printf("CodecTest passed\n");
+  }
+  return failures == 0 ? 0 : 1;
+}
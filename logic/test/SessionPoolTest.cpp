@@ -0,0 +1,57 @@
+// 会话对象池的析构测试：空闲会话和对象池之间不能互相引用，
+// 对象池释放后它和空闲会话都要析构；比对象池活得久的会话释放时直接删除
+#include "../CSession.h"
+#include "../MemoryPool.h"
+#include "../Runtime.h"
+#include "../SessionPool.h"
+#include <cstdio>
+#include <memory>
+
+static int failures = 0;
+
+static void check(bool cond, const char *what) {
+  if (!cond) {
+    std::printf("FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+static std::uint64_t inUseBytes() {
+  return MemoryPool::instance().stats().inUseBytes;
+}
+
+int main() {
+  Runtime runtime(1, LOGIC_THREADED);
+  auto &ioc = runtime.getIOServicePool().getIOService(0);
+  // 会话的发送队列哨兵和控制块都从内存池分配，会话析构后才归还
+  std::uint64_t baseline = inUseBytes();
+
+  auto pool = std::make_shared<SessionPool>(runtime, nullptr);
+  std::weak_ptr<SessionPool> weakPool = pool;
+  {
+    auto first = pool->acquire(boost::asio::ip::tcp::socket(ioc), 0);
+    auto second = pool->acquire(boost::asio::ip::tcp::socket(ioc), 0);
+  }
+  check(pool->idleCount() == 2, "released sessions go back to the pool");
+  check(inUseBytes() > baseline, "idle sessions keep their pool memory");
+
+  pool.reset();
+  check(weakPool.expired(), "pool destroyed while holding idle sessions");
+  check(inUseBytes() == baseline, "idle sessions destroyed with the pool");
+
+  // 会话比对象池活得久
+  pool = std::make_shared<SessionPool>(runtime, nullptr);
+  weakPool = pool;
+  auto survivor = pool->acquire(boost::asio::ip::tcp::socket(ioc), 0);
+  pool.reset();
+  check(weakPool.expired(), "pool destroyed while a session is in use");
+  survivor.reset();
+  check(inUseBytes() == baseline, "session outliving the pool is deleted");
+
+  runtime.stop();
+  if (failures != 0) {
+    return 1;
+  }
+  std::printf("SessionPoolTest passed\n");
+  return 0;
+}